@@ -6,12 +6,19 @@
 
 #include <SDL3/SDL_hints.h>
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <iostream>
 
 namespace PaperPup::Audio
 {
 
+static int64_t ClockNow()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 void Backend::SDLAudioCallback(void *userdata, SDL_AudioStream *stream, int additional_amount, int total_amount)
 {
 	Backend *audio = reinterpret_cast<Backend *>(userdata);
@@ -24,12 +31,51 @@ void Backend::SDLAudioCallback(void *userdata, SDL_AudioStream *stream, int addi
 
 		if (audio->mix_callback != nullptr)
 		{
+			// Mix in chunks so the mixer can use fixed size buffers
 			size_t frames = static_cast<size_t>(additional_amount) / sizeof(int16_t) / 2;
-			SDL_PutAudioStreamData(stream, audio->mix_callback(frames), additional_amount);
+			while (frames != 0)
+			{
+				size_t chunk = std::min(frames, MIX_FRAMES_MAX);
+				SDL_PutAudioStreamData(stream, audio->mix_callback(chunk), static_cast<int>(chunk * sizeof(int16_t) * 2));
+
+				audio->frames_mixed += chunk;
+				frames -= chunk;
+			}
+
+			audio->UpdateClock(stream);
 		}
 	}
 }
 
+void Backend::UpdateClock(SDL_AudioStream *stream)
+{
+	int64_t now = ClockNow();
+
+	// Everything mixed has been played except what's still queued in the stream and the device buffer
+	int queued = SDL_GetAudioStreamQueued(stream);
+	uint64_t latency = (queued > 0 ? static_cast<uint64_t>(queued) / sizeof(int16_t) / 2 : 0) + device_frames;
+	uint64_t played = frames_mixed > latency ? frames_mixed - latency : 0;
+
+	// Publish the clock
+	uint32_t sequence = clock_sequence.load(std::memory_order_relaxed);
+	clock_sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	clock_frames.store(played, std::memory_order_relaxed);
+	clock_mixed.store(frames_mixed, std::memory_order_relaxed);
+	clock_time.store(now, std::memory_order_relaxed);
+	clock_latency.store(static_cast<uint32_t>(latency), std::memory_order_relaxed);
+
+	clock_sequence.store(sequence + 2, std::memory_order_release);
+
+	// Remember when the first frame played (or will play) to measure drift against
+	if (clock_start.load(std::memory_order_relaxed) == 0)
+	{
+		int64_t played_ns = (static_cast<int64_t>(frames_mixed) - static_cast<int64_t>(latency)) * 1000000000 / static_cast<int64_t>(output_frequency);
+		clock_start.store(now - played_ns, std::memory_order_relaxed);
+	}
+}
+
 Backend::Backend()
 {
 	// Require SDL
@@ -76,6 +122,12 @@ Backend::Backend()
 	if (output_device == 0)
 		throw Types::SDLException();
 
+	// Get the device buffer size for latency compensation
+	SDL_AudioSpec device_spec = {};
+	int device_sample_frames = 0;
+	if (SDL_GetAudioDeviceFormat(output_device, &device_spec, &device_sample_frames) && device_sample_frames > 0)
+		device_frames = static_cast<uint32_t>(device_sample_frames);
+
 	SDL_ResumeAudioStreamDevice(output_stream);
 }
 
@@ -93,6 +145,54 @@ uint32_t Backend::GetFrequency() const
 	return output_frequency;
 }
 
+uint64_t Backend::GetPlayedFrames() const
+{
+	// Read a consistent snapshot of the clock
+	uint64_t frames, mixed;
+	int64_t time;
+
+	uint32_t sequence;
+	do
+	{
+		sequence = clock_sequence.load(std::memory_order_acquire);
+		frames = clock_frames.load(std::memory_order_relaxed);
+		mixed = clock_mixed.load(std::memory_order_relaxed);
+		time = clock_time.load(std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_acquire);
+	} while ((sequence & 1) != 0 || sequence != clock_sequence.load(std::memory_order_relaxed));
+
+	if (time == 0)
+		return 0;
+
+	// Interpolate from the last mix, but never past what was actually mixed
+	int64_t elapsed = ClockNow() - time;
+	if (elapsed > 0)
+		frames += static_cast<uint64_t>(elapsed) * output_frequency / 1000000000;
+	if (frames > mixed)
+		frames = mixed;
+
+	// Never go backwards, even if a mix comes in with more latency than expected
+	uint64_t last = clock_last.load(std::memory_order_relaxed);
+	while (frames > last && !clock_last.compare_exchange_weak(last, frames, std::memory_order_relaxed));
+	return std::max(frames, last);
+}
+
+uint32_t Backend::GetLatencyFrames() const
+{
+	return clock_latency.load(std::memory_order_relaxed);
+}
+
+double Backend::GetClockDrift() const
+{
+	int64_t start = clock_start.load(std::memory_order_relaxed);
+	if (start == 0)
+		return 0.0;
+
+	double audio_seconds = static_cast<double>(GetPlayedFrames()) / output_frequency;
+	double steady_seconds = static_cast<double>(ClockNow() - start) / 1000000000.0;
+	return audio_seconds - steady_seconds;
+}
+
 void Backend::SetMixCallback(MixCallback callback)
 {
 	Lock();
@@ -2,6 +2,7 @@
 
 #include <span>
 #include <cstdint>
+#include <atomic>
 
 #include <SDL3/SDL_audio.h>
 
@@ -10,11 +11,16 @@ namespace PaperPup::Audio
 
 class Backend
 {
+public:
+	// The mix callback is never asked for more than this many frames at once
+	static constexpr size_t MIX_FRAMES_MAX = 1024;
+
 private:
 	SDL_AudioStream *output_stream = nullptr;
 	SDL_AudioDeviceID output_device = 0;
 
 	uint32_t output_frequency = 0;
+	uint32_t device_frames = 0;
 
 	typedef const int16_t *(*MixCallback)(size_t frames);
 
@@ -22,6 +28,21 @@ private:
 
 	static void SDLAudioCallback(void *userdata, SDL_AudioStream *stream, int additional_amount, int total_amount);
 
+	// Audio clock
+	// Written by the audio thread after every mix, read lock-free through a sequence counter
+	std::atomic<uint32_t> clock_sequence = 0;
+	std::atomic<uint64_t> clock_frames = 0; // Frames played as of `clock_time`
+	std::atomic<uint64_t> clock_mixed = 0; // Frames mixed as of `clock_time`
+	std::atomic<int64_t> clock_time = 0;
+	std::atomic<uint32_t> clock_latency = 0;
+
+	std::atomic<int64_t> clock_start = 0; // When the first frame was expected to play
+	mutable std::atomic<uint64_t> clock_last = 0;
+
+	uint64_t frames_mixed = 0;
+
+	void UpdateClock(SDL_AudioStream *stream);
+
 private:
 	Backend();
 	~Backend();
@@ -31,6 +52,13 @@ public:
 
 	uint32_t GetFrequency() const;
 
+	// Number of frames played by the device, monotonic and interpolated between mixes
+	uint64_t GetPlayedFrames() const;
+	// Frames between the mixer and the speaker, queued in the stream and the device buffer
+	uint32_t GetLatencyFrames() const;
+	// Seconds the audio clock has drifted ahead of std::chrono::steady_clock since playback started
+	double GetClockDrift() const;
+
 	void SetMixCallback(MixCallback callback);
 
 	void Lock();
@@ -0,0 +1,287 @@
+#include "Backend/Audio/Mixer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PAPERPUP_MIXER_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace PaperPup::Audio
+{
+
+// Sample kernels
+// Both work on interleaved stereo samples, so `samples` is twice the frame count
+#ifdef PAPERPUP_MIXER_SSE2
+static void Accumulate(int32_t *acc, const int16_t *in, int16_t gain_l, int16_t gain_r, size_t samples)
+{
+	// Full 32-bit products are put back together from their low and high halves
+	const __m128i gain = _mm_set_epi16(gain_r, gain_l, gain_r, gain_l, gain_r, gain_l, gain_r, gain_l);
+
+	size_t i = 0;
+	for (; i + 8 <= samples; i += 8)
+	{
+		__m128i sample = _mm_load_si128(reinterpret_cast<const __m128i *>(in + i));
+		__m128i lo = _mm_mullo_epi16(sample, gain);
+		__m128i hi = _mm_mulhi_epi16(sample, gain);
+
+		__m128i *dst = reinterpret_cast<__m128i *>(acc + i);
+		_mm_store_si128(dst + 0, _mm_add_epi32(_mm_load_si128(dst + 0), _mm_srai_epi32(_mm_unpacklo_epi16(lo, hi), 14)));
+		_mm_store_si128(dst + 1, _mm_add_epi32(_mm_load_si128(dst + 1), _mm_srai_epi32(_mm_unpackhi_epi16(lo, hi), 14)));
+	}
+
+	// Leftover frames, always whole since `samples` is even
+	for (; i < samples; i += 2)
+	{
+		acc[i + 0] += (in[i + 0] * gain_l) >> 14;
+		acc[i + 1] += (in[i + 1] * gain_r) >> 14;
+	}
+}
+
+static void Pack(int16_t *out, const int32_t *acc, size_t samples)
+{
+	size_t i = 0;
+	for (; i + 8 <= samples; i += 8)
+	{
+		const __m128i *src = reinterpret_cast<const __m128i *>(acc + i);
+		_mm_store_si128(reinterpret_cast<__m128i *>(out + i), _mm_packs_epi32(_mm_load_si128(src + 0), _mm_load_si128(src + 1)));
+	}
+
+	for (; i < samples; i++)
+		out[i] = static_cast<int16_t>(std::clamp<int32_t>(acc[i], -0x8000, 0x7FFF));
+}
+#else
+static void Accumulate(int32_t *acc, const int16_t *in, int16_t gain_l, int16_t gain_r, size_t samples)
+{
+	for (size_t i = 0; i < samples; i += 2)
+	{
+		acc[i + 0] += (in[i + 0] * gain_l) >> 14;
+		acc[i + 1] += (in[i + 1] * gain_r) >> 14;
+	}
+}
+
+static void Pack(int16_t *out, const int32_t *acc, size_t samples)
+{
+	for (size_t i = 0; i < samples; i++)
+		out[i] = static_cast<int16_t>(std::clamp<int32_t>(acc[i], -0x8000, 0x7FFF));
+}
+#endif
+
+// Mixer
+Mixer::Mixer()
+{
+	Backend::Instance().SetMixCallback(MixCallback);
+}
+
+Mixer::~Mixer()
+{
+	Backend::Instance().SetMixCallback(nullptr);
+}
+
+const int16_t *Mixer::MixCallback(size_t frames)
+{
+	return Instance().Mix(frames);
+}
+
+const int16_t *Mixer::Mix(size_t frames)
+{
+	std::fill(mix_accumulate, mix_accumulate + frames * 2, 0);
+
+	for (auto &voice : voices)
+	{
+		if (voice.source == nullptr)
+			continue;
+
+		size_t rendered = Render(voice, mix_voice, frames);
+		Accumulate(mix_accumulate, mix_voice, voice.gain_l, voice.gain_r, rendered * 2);
+
+		// The source ran out
+		if (rendered < frames)
+			voice.source = nullptr;
+	}
+
+	Pack(mix_output, mix_accumulate, frames * 2);
+	return mix_output;
+}
+
+size_t Mixer::Render(Voice &voice, int16_t *out, size_t frames)
+{
+	// Frames can be read straight through when not resampling
+	if (voice.step == 0x10000 && voice.phase == 0 && voice.buffer_pos <= voice.buffer_size)
+	{
+		size_t copy = std::min(frames, voice.buffer_size - voice.buffer_pos);
+		std::memcpy(out, voice.buffer + voice.buffer_pos * 2, copy * 2 * sizeof(int16_t));
+		voice.buffer_pos += copy;
+
+		if (copy == frames)
+			return frames;
+		return copy + voice.source->Read(out + copy * 2, frames - copy);
+	}
+
+	// Linearly interpolate between buffered frames
+	for (size_t i = 0; i < frames; i++)
+	{
+		while (voice.buffer_pos + 1 >= voice.buffer_size)
+		{
+			if (!Refill(voice))
+				return i;
+		}
+
+		const int16_t *frame = voice.buffer + voice.buffer_pos * 2;
+		int32_t frac = static_cast<int32_t>(voice.phase >> 1);
+		out[i * 2 + 0] = static_cast<int16_t>(frame[0] + (((frame[2] - frame[0]) * frac) >> 15));
+		out[i * 2 + 1] = static_cast<int16_t>(frame[1] + (((frame[3] - frame[1]) * frac) >> 15));
+
+		voice.phase += voice.step;
+		voice.buffer_pos += voice.phase >> 16;
+		voice.phase &= 0xFFFF;
+	}
+
+	return frames;
+}
+
+bool Mixer::Refill(Voice &voice)
+{
+	// Keep the frames from the current one onwards, or skip past the end of the buffer
+	if (voice.buffer_pos < voice.buffer_size)
+	{
+		size_t keep = voice.buffer_size - voice.buffer_pos;
+		std::memmove(voice.buffer, voice.buffer + voice.buffer_pos * 2, keep * 2 * sizeof(int16_t));
+		voice.buffer_pos = 0;
+		voice.buffer_size = keep;
+	}
+	else
+	{
+		voice.buffer_pos -= voice.buffer_size;
+		voice.buffer_size = 0;
+	}
+
+	size_t read = voice.source->Read(voice.buffer + voice.buffer_size * 2, BUFFER_FRAMES - voice.buffer_size);
+	voice.buffer_size += read;
+	return read != 0;
+}
+
+Mixer::Voice *Mixer::Find(VoiceID id)
+{
+	Voice &voice = voices[(id & 0xFF) % VOICES];
+	if (voice.source == nullptr || voice.generation != (id >> 8))
+		return nullptr;
+	return &voice;
+}
+
+void Mixer::SetGain(Voice &voice, float volume, float pan)
+{
+	// Panning only ever attenuates the opposite side
+	pan = std::clamp(pan, -1.0f, 1.0f);
+	float l = std::clamp(volume * std::min(1.0f, 1.0f - pan), 0.0f, 1.99f);
+	float r = std::clamp(volume * std::min(1.0f, 1.0f + pan), 0.0f, 1.99f);
+
+	voice.gain_l = static_cast<int16_t>(std::lround(l * 0x4000));
+	voice.gain_r = static_cast<int16_t>(std::lround(r * 0x4000));
+}
+
+void Mixer::SetStep(Voice &voice, float pitch)
+{
+	// Steps are limited to 8 source frames per output frame
+	voice.pitch = pitch;
+
+	double step = static_cast<double>(voice.source->GetFrequency()) * pitch / Backend::Instance().GetFrequency();
+	voice.step = static_cast<uint32_t>(std::clamp<double>(std::round(step * 0x10000), 1.0, 0x80000));
+}
+
+Mixer::VoiceID Mixer::Play(Source &source, float volume, float pan, float pitch)
+{
+	auto &audio = Backend::Instance();
+	audio.Lock();
+
+	VoiceID id = 0;
+	for (size_t i = 0; i < VOICES; i++)
+	{
+		Voice &voice = voices[i];
+		if (voice.source != nullptr)
+			continue;
+
+		// Generations wrap at 24 bits, skipping 0 so no ID is ever 0
+		voice.generation = (voice.generation + 1) & 0xFFFFFF;
+		if (voice.generation == 0)
+			voice.generation = 1;
+
+		voice.source = &source;
+		voice.phase = 0;
+		voice.buffer_pos = 0;
+		voice.buffer_size = 0;
+		SetGain(voice, volume, pan);
+		SetStep(voice, pitch);
+
+		id = (voice.generation << 8) | static_cast<VoiceID>(i);
+		break;
+	}
+
+	audio.Unlock();
+	return id;
+}
+
+void Mixer::Stop(VoiceID id)
+{
+	auto &audio = Backend::Instance();
+	audio.Lock();
+
+	if (Voice *voice = Find(id))
+		voice->source = nullptr;
+
+	audio.Unlock();
+}
+
+void Mixer::StopAll()
+{
+	auto &audio = Backend::Instance();
+	audio.Lock();
+
+	for (auto &voice : voices)
+		voice.source = nullptr;
+
+	audio.Unlock();
+}
+
+void Mixer::SetVolume(VoiceID id, float volume, float pan)
+{
+	auto &audio = Backend::Instance();
+	audio.Lock();
+
+	if (Voice *voice = Find(id))
+		SetGain(*voice, volume, pan);
+
+	audio.Unlock();
+}
+
+void Mixer::SetPitch(VoiceID id, float pitch)
+{
+	auto &audio = Backend::Instance();
+	audio.Lock();
+
+	if (Voice *voice = Find(id))
+		SetStep(*voice, pitch);
+
+	audio.Unlock();
+}
+
+bool Mixer::Playing(VoiceID id)
+{
+	auto &audio = Backend::Instance();
+	audio.Lock();
+
+	bool playing = Find(id) != nullptr;
+
+	audio.Unlock();
+	return playing;
+}
+
+Mixer &Mixer::Instance()
+{
+	static Mixer instance;
+	return instance;
+}
+
+}
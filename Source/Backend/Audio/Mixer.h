@@ -0,0 +1,99 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "Backend/Audio.h"
+
+namespace PaperPup::Audio
+{
+
+// Something a voice can play
+class Source
+{
+public:
+	virtual ~Source() = default;
+
+	// Called from the audio thread
+	// Writes up to `frames` interleaved stereo frames to `out`, returning how many were written
+	// Writing fewer frames than asked for ends the voice playing it
+	virtual size_t Read(int16_t *out, size_t frames) = 0;
+
+	virtual uint32_t GetFrequency() const = 0;
+};
+
+// Software mixer with a fixed pool of voices
+// Installs itself as the backend's mix callback, voices are mixed in 32-bit and saturated to 16-bit once at the end
+// Nothing is allocated on the audio thread
+class Mixer
+{
+public:
+	static constexpr size_t VOICES = 32;
+
+	// Identifies a voice for as long as it plays, 0 is never a valid voice
+	typedef uint32_t VoiceID;
+
+private:
+	// Source frames buffered per voice for resampling
+	static constexpr size_t BUFFER_FRAMES = 256;
+
+	struct Voice
+	{
+		Source *source = nullptr;
+		uint32_t generation = 0;
+
+		// 2.14 fixed point
+		int16_t gain_l = 0, gain_r = 0;
+
+		float pitch = 1.0f;
+
+		// 16.16 fixed point step through the source, and position between the current and next frame
+		uint32_t step = 0x10000;
+		uint32_t phase = 0;
+
+		// Buffered source frames, `buffer_pos` may be past the end when skipping frames
+		size_t buffer_pos = 0, buffer_size = 0;
+		alignas(16) int16_t buffer[BUFFER_FRAMES * 2];
+	};
+
+	std::array<Voice, VOICES> voices;
+
+	// Mix buffers
+	alignas(16) int32_t mix_accumulate[Backend::MIX_FRAMES_MAX * 2];
+	alignas(16) int16_t mix_voice[Backend::MIX_FRAMES_MAX * 2];
+	alignas(16) int16_t mix_output[Backend::MIX_FRAMES_MAX * 2];
+
+	static const int16_t *MixCallback(size_t frames);
+	const int16_t *Mix(size_t frames);
+
+	size_t Render(Voice &voice, int16_t *out, size_t frames);
+	bool Refill(Voice &voice);
+
+	Voice *Find(VoiceID id);
+
+	void SetGain(Voice &voice, float volume, float pan);
+	void SetStep(Voice &voice, float pitch);
+
+private:
+	Mixer();
+	~Mixer();
+
+public:
+	static Mixer &Instance();
+
+	// Starts playing a source on a free voice, returning 0 if there is none
+	// The source must stay alive until the voice ends or is stopped
+	// `pan` goes from -1 (left) to 1 (right), `pitch` scales the source's frequency
+	VoiceID Play(Source &source, float volume = 1.0f, float pan = 0.0f, float pitch = 1.0f);
+
+	// Once this returns, the audio thread no longer touches the voice's source
+	void Stop(VoiceID id);
+	void StopAll();
+
+	void SetVolume(VoiceID id, float volume, float pan = 0.0f);
+	void SetPitch(VoiceID id, float pitch);
+
+	bool Playing(VoiceID id);
+};
+
+}
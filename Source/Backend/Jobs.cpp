@@ -0,0 +1,191 @@
+#include "Backend/Jobs.h"
+
+#include <atomic>
+#include <exception>
+#include <memory>
+
+namespace PaperPup::Jobs
+{
+
+// Index of the worker running on this thread, or -1 on other threads
+static thread_local size_t current_worker = static_cast<size_t>(-1);
+
+Backend::Backend()
+{
+	// Leave one hardware thread for the main thread
+	unsigned int count = std::thread::hardware_concurrency();
+	count = count > 2 ? count - 1 : 1;
+
+	for (unsigned int i = 0; i < count; i++)
+		workers.emplace_back(std::make_unique<Worker>());
+
+	// Start threads once every queue exists, since they may steal from any of them
+	for (size_t i = 0; i < workers.size(); i++)
+	{
+		workers[i]->thread = std::thread([this, i]()
+			{
+				current_worker = i;
+				Run(i);
+			}
+		);
+	}
+}
+
+Backend::~Backend()
+{
+	{
+		std::lock_guard<std::mutex> lock(sleep_mutex);
+		quit = true;
+	}
+	condition.notify_all();
+
+	for (auto &worker : workers)
+		worker->thread.join();
+}
+
+bool Backend::Pop(size_t index, std::function<void()> &job)
+{
+	Worker &worker = *workers[index];
+	std::lock_guard<std::mutex> lock(worker.mutex);
+	if (worker.queue.empty())
+		return false;
+
+	job = std::move(worker.queue.back());
+	worker.queue.pop_back();
+	return true;
+}
+
+bool Backend::Steal(size_t index, std::function<void()> &job)
+{
+	for (size_t i = 1; i < workers.size(); i++)
+	{
+		Worker &victim = *workers[(index + i) % workers.size()];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (victim.queue.empty())
+			continue;
+
+		job = std::move(victim.queue.front());
+		victim.queue.pop_front();
+		steals.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+	return false;
+}
+
+void Backend::Run(size_t index)
+{
+	while (1)
+	{
+		std::function<void()> job;
+		if (Pop(index, job) || Steal(index, job))
+		{
+			pending.fetch_sub(1, std::memory_order_relaxed);
+			job();
+			continue;
+		}
+
+		// Sleep until there's something to run
+		std::unique_lock<std::mutex> lock(sleep_mutex);
+		condition.wait(lock, [this]() { return quit || pending.load(std::memory_order_relaxed) != 0; });
+		if (quit)
+			return;
+	}
+}
+
+size_t Backend::Threads() const
+{
+	return workers.size();
+}
+
+void Backend::Submit(std::function<void()> job)
+{
+	size_t index = current_worker;
+	if (index >= workers.size())
+		index = next_worker.fetch_add(1, std::memory_order_relaxed) % workers.size();
+
+	// Counted before it's queued so the count never drops below zero
+	pending.fetch_add(1, std::memory_order_relaxed);
+	{
+		Worker &worker = *workers[index];
+		std::lock_guard<std::mutex> lock(worker.mutex);
+		worker.queue.emplace_back(std::move(job));
+	}
+
+	// Taking the lock makes sure a worker about to sleep sees the job
+	{
+		std::lock_guard<std::mutex> lock(sleep_mutex);
+	}
+	condition.notify_one();
+}
+
+void Backend::ParallelFor(size_t count, const std::function<void(size_t)> &func)
+{
+	if (count == 0)
+		return;
+
+	// Shared with the helpers, which may only get to run after everything's done
+	struct State
+	{
+		const std::function<void(size_t)> *func;
+		size_t count;
+
+		std::atomic<size_t> next = 0;
+		std::atomic<size_t> done = 0;
+
+		std::mutex error_mutex;
+		std::exception_ptr error;
+
+		void Run()
+		{
+			size_t i;
+			while ((i = next.fetch_add(1, std::memory_order_relaxed)) < count)
+			{
+				try
+				{
+					(*func)(i);
+				}
+				catch (...)
+				{
+					std::lock_guard<std::mutex> lock(error_mutex);
+					if (!error)
+						error = std::current_exception();
+				}
+
+				if (done.fetch_add(1, std::memory_order_acq_rel) + 1 == count)
+					done.notify_all();
+			}
+		}
+	};
+
+	auto state = std::make_shared<State>();
+	state->func = &func;
+	state->count = count;
+
+	// Indices are claimed one at a time, so helpers beyond the first few just find nothing left
+	size_t helpers = std::min(workers.size(), count - 1);
+	for (size_t i = 0; i < helpers; i++)
+		Submit([state]() { state->Run(); });
+
+	state->Run();
+
+	// Wait for calls still running on other threads
+	size_t done;
+	while ((done = state->done.load(std::memory_order_acquire)) != count)
+		state->done.wait(done, std::memory_order_acquire);
+
+	if (state->error)
+		std::rethrow_exception(state->error);
+}
+
+uint64_t Backend::GetSteals() const
+{
+	return steals.load(std::memory_order_relaxed);
+}
+
+Backend &Backend::Instance()
+{
+	static Backend instance;
+	return instance;
+}
+
+}
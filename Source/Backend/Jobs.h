@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace PaperPup::Jobs
+{
+
+// Work-stealing pool of worker threads for load time work
+// Every worker has its own queue, which it runs newest first, and steals the oldest jobs of other workers when it runs dry
+class Backend
+{
+private:
+	struct Worker
+	{
+		std::thread thread;
+
+		std::mutex mutex;
+		std::deque<std::function<void()>> queue;
+	};
+	std::vector<std::unique_ptr<Worker>> workers;
+
+	// Sleeping workers wait for jobs here
+	std::mutex sleep_mutex;
+	std::condition_variable condition;
+	std::atomic<size_t> pending = 0;
+	std::atomic<size_t> next_worker = 0;
+	bool quit = false;
+
+	// Statistics
+	std::atomic<uint64_t> steals = 0;
+
+	bool Pop(size_t index, std::function<void()> &job);
+	bool Steal(size_t index, std::function<void()> &job);
+	void Run(size_t index);
+
+private:
+	Backend();
+	~Backend();
+
+public:
+	static Backend &Instance();
+
+	size_t Threads() const;
+
+	// Runs a job on a worker thread
+	// Jobs submitted from a worker go on its own queue
+	void Submit(std::function<void()> job);
+
+	// Calls `func` for every index in [0, count) across the workers and the calling thread, returning once all calls are done
+	// If any call throws, the first exception is rethrown here
+	void ParallelFor(size_t count, const std::function<void(size_t)> &func);
+
+	// Number of jobs taken from another worker's queue
+	uint64_t GetSteals() const;
+};
+
+}
@@ -1,6 +1,8 @@
 #include "Backend/VFS/DataSource/Folder.h"
 
-#include <fstream>
+#include "Types/MmapFile.h"
+
+#include <system_error>
 
 namespace PaperPup::VFS::DataSource
 {
@@ -33,13 +35,14 @@ Types::File *Folder::Open(const Path &name)
 			str_from = str_p + 1;
 		}
 	}
+	path /= std::string(str_from, static_cast<size_t>(str_p - str_from));
 
-	// Open file
-	std::ifstream file(folder_path / path, std::ios::binary);
-	if (!file.is_open())
+	// Map file
+	std::error_code error;
+	if (!std::filesystem::is_regular_file(folder_path / path, error))
 		return nullptr;
 
-	return new Types::StlFile(file);
+	return new Types::MmapFile(folder_path / path);
 }
 
 }
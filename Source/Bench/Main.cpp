@@ -0,0 +1,178 @@
+#include "PS1/INT.h"
+#include "PS1/TMD.h"
+#include "PS1/TMDMesh.h"
+
+#include "Types/Exceptions.h"
+#include "Types/File.h"
+#include "Types/MmapFile.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Load time benchmarks, run by hand over game data since none of it can be shipped
+namespace PaperPup::Bench
+{
+
+using Clock = std::chrono::steady_clock;
+
+static double Seconds(Clock::duration duration)
+{
+	return std::chrono::duration<double>(duration).count();
+}
+
+static bool HasExtension(const std::filesystem::path &path, const char *extension)
+{
+	std::string string = path.extension().string();
+	std::transform(string.begin(), string.end(), string.begin(), [](char c) { return static_cast<char>(std::toupper(static_cast<unsigned char>(c))); });
+	return string == extension;
+}
+
+// Builds every object of every TMD in a directory with the hashed and the linear welder,
+// checks they give the same meshes and prints how fast each went
+static int Weld(const std::filesystem::path &directory)
+{
+	std::vector<std::unique_ptr<TMD::Data>> models;
+	size_t objects = 0;
+	size_t tmd_vertices = 0;
+
+	for (auto &entry : std::filesystem::recursive_directory_iterator(directory))
+	{
+		if (!entry.is_regular_file() || !HasExtension(entry.path(), ".TMD"))
+			continue;
+
+		Types::MmapFile file(entry.path(), Types::MmapFile::Access_Sequential);
+		auto &data = models.emplace_back(std::make_unique<TMD::Data>(file));
+
+		objects += data->objects_size;
+		for (uint32_t i = 0; i < data->objects_size; i++)
+			tmd_vertices += data->objects[i].vertex_size;
+	}
+
+	if (models.empty())
+	{
+		std::cerr << "No TMDs found in " << directory.string() << std::endl;
+		return 1;
+	}
+
+	std::cout << models.size() << " TMDs, " << objects << " objects, " << tmd_vertices << " vertices" << std::endl;
+
+	// Build everything with one welder, keeping the meshes to compare afterwards
+	auto build = [&](TMD::Weld weld, std::vector<TMD::MeshData> &meshes)
+	{
+		meshes.clear();
+		meshes.reserve(objects);
+
+		auto start = Clock::now();
+		for (auto &data : models)
+		{
+			for (uint32_t i = 0; i < data->objects_size; i++)
+				meshes.push_back(TMD::BuildMesh(data->objects[i], false, weld));
+		}
+		return Seconds(Clock::now() - start);
+	};
+
+	std::vector<TMD::MeshData> linear, hashed;
+	double linear_time = build(TMD::Weld_Linear, linear);
+	double hashed_time = build(TMD::Weld_Hashed, hashed);
+
+	size_t mismatches = 0;
+	for (size_t i = 0; i < objects; i++)
+	{
+		if (linear[i].vertices != hashed[i].vertices || linear[i].vertex_sources != hashed[i].vertex_sources || linear[i].indices != hashed[i].indices)
+			mismatches++;
+	}
+
+	std::cout << "linear: " << linear_time << "s, " << static_cast<double>(tmd_vertices) / linear_time << " vertices/s" << std::endl;
+	std::cout << "hashed: " << hashed_time << "s, " << static_cast<double>(tmd_vertices) / hashed_time << " vertices/s" << std::endl;
+
+	if (mismatches != 0)
+	{
+		std::cerr << mismatches << " objects welded differently" << std::endl;
+		return 1;
+	}
+	std::cout << "Index buffers identical" << std::endl;
+	return 0;
+}
+
+// Opens an INT through StlFile and MmapFile, parses its directory and opens every TIM and VAB in it
+// The first member word is read, since that's all a parser needs to reject a bad file
+static int OpenINT(const std::filesystem::path &path, size_t iterations)
+{
+	auto run = [&](const char *name, const std::function<std::shared_ptr<Types::File>()> &open)
+	{
+		size_t members = 0;
+		uint32_t check = 0;
+
+		auto start = Clock::now();
+		for (size_t i = 0; i < iterations; i++)
+		{
+			INT::INT int_file(open());
+			for (auto *names : { &int_file.TIMs(), &int_file.VABs() })
+			{
+				for (auto &member_name : *names)
+				{
+					INT::Member member = int_file.Open(member_name);
+					if (member.GetSpan().Size() >= sizeof(uint32_t))
+						check ^= member.Get<uint32_t>(0);
+					members++;
+				}
+			}
+		}
+		double time = Seconds(Clock::now() - start);
+
+		// Per INT, which is parsing it and opening all of its members
+		std::cout << name << ": " << time * 1000.0 / static_cast<double>(iterations) << "ms per INT, " << members / iterations << " members (" << check << ")" << std::endl;
+	};
+
+	std::cout << path.string() << ", " << std::filesystem::file_size(path) << " bytes, " << iterations << " iterations" << std::endl;
+
+	// Both run with the file already in the page cache, which is what a real load sees after the first
+	run("StlFile", [&]()
+	{
+		std::ifstream stream(path, std::ios::binary);
+		if (!stream)
+			throw Types::RuntimeException("Failed to open INT");
+		return std::make_shared<Types::StlFile>(stream);
+	});
+	run("MmapFile", [&]()
+	{
+		return std::make_shared<Types::MmapFile>(path, Types::MmapFile::Access_Random);
+	});
+	return 0;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+	try
+	{
+		if (argc == 3 && std::strcmp(argv[1], "weld") == 0)
+			return PaperPup::Bench::Weld(argv[2]);
+		if ((argc == 3 || argc == 4) && std::strcmp(argv[1], "int") == 0)
+		{
+			size_t iterations = argc == 4 ? std::stoul(argv[3]) : 20;
+			if (iterations != 0)
+				return PaperPup::Bench::OpenINT(argv[2], iterations);
+		}
+	}
+	catch (const std::exception &exception)
+	{
+		std::cerr << exception.what() << std::endl;
+		return 1;
+	}
+
+	std::cerr << "Usage:" << std::endl;
+	std::cerr << "  " << argv[0] << " weld <directory of TMDs>" << std::endl;
+	std::cerr << "  " << argv[0] << " int <INT file> [iterations, at least 1]" << std::endl;
+	return 1;
+}
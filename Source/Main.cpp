@@ -4,18 +4,23 @@
 #include "Backend/VFS.h"
 #include "Backend/Render.h"
 #include "Backend/Audio.h"
+#include "Backend/Audio/Mixer.h"
 
 #include <iostream>
 #include <fstream>
 #include <vector>
 #include <array>
 #include <memory>
+#include <algorithm>
 
 #include "Types/File.h"
 #include "PS1/INT.h"
 
 #include "PS1/VDF.h"
 #include "PS1/TMD.h"
+#include "PS1/TMDMesh.h"
+#include "PS1/TMDCache.h"
+#include "PS1/TMDModel.h"
 #include "PS1/VDFActor.h"
 #include "PS1/Context.h"
 
@@ -27,7 +32,7 @@
 
 #include "Types/Span.h"
 
-#include "PS1/ADPCM.h"
+#include "PS1/XAStream.h"
 
 #include "clownresampler.h"
 
@@ -39,48 +44,19 @@
 namespace PaperPup
 {
 
-static PS1::XADecode::XASectorOut xa_buffer;
-static PS1::XADecode xa_decoder;
-static uint64_t xa_sample_p = 0;
+static std::unique_ptr<PS1::XAStream> xa_stream;
 
 static ClownResampler_Precomputed precomputed;
 static ClownResampler_HighLevel_State resampler;
 
-static std::ifstream stream("C:/Users/CKDEV/Documents/DuckStation/isos/rapper/Image/S2/STAGE2.XA1", std::ios::binary);
-
 static size_t ResamplerInputCallback(void *user_data, cc_s16l *buffer, size_t total_frames)
 {
 	(void)user_data;
 
-	static char sector[0x920];
-	for (size_t i = 0; i < total_frames; i++)
-	{
-		while (xa_sample_p >= xa_buffer.samples_count)
-		{
-			xa_sample_p -= xa_buffer.samples_count;
-			while (1)
-			{
-				stream.read(sector, sizeof(sector));
-				if (!stream)
-					goto ItsOver;
-				PS1::SubHeader &subheader = *reinterpret_cast<PS1::SubHeader *>(sector);
-				if (subheader.file != 1 || subheader.channel != 1)
-					continue;
-				xa_decoder.DecodeXASector(Types::Span<const char, 0x920>(sector), xa_buffer);
-				break;
-			}
-		}
+	// Pad anything the stream couldn't provide with silence
+	size_t frames = xa_stream != nullptr ? xa_stream->Read(0, buffer, total_frames) : 0;
+	std::fill(buffer + frames * 2, buffer + total_frames * 2, 0);
 
-		int16_t sample_l = xa_buffer.samples[xa_sample_p][0];
-		int16_t sample_r = xa_buffer.samples[xa_sample_p][1];
-
-		*buffer++ = sample_l;
-		*buffer++ = sample_r;
-
-		xa_sample_p += 1;
-	}
-
-	ItsOver:
 	return total_frames;
 }
 
@@ -120,36 +96,62 @@ static cc_bool ResamplerOutputCallback(void *user_data, const cc_s32f *frame, cc
 	return --callback_data->output_buffer_frames_remaining != 0;
 }
 
-// Game entry point
-static void Main()
+// Plays the XA stream resampled to the output frequency
+class MusicSource : public Audio::Source
 {
-	Core::Backend::Instance();
-	VFS::Backend::Instance();
-	Render::Backend::Instance();
-	auto &audio = Audio::Backend::Instance();
-	(void)audio;
+private:
+	uint32_t frequency;
 
-	ClownResampler_Precompute(&precomputed);
-	ClownResampler_HighLevel_Init(&resampler, 2, 37800, audio.GetFrequency(), 44100);
+public:
+	MusicSource(uint32_t _frequency) : frequency(_frequency) {}
 
-	audio.SetMixCallback([](size_t frames)
+	size_t Read(int16_t *out, size_t frames) override
 	{
-		static std::vector<std::array<int16_t, 2>> out;
-		out.resize(frames);
-
 		ResamplerCallbackData callback_data;
 
-		callback_data.output_pointer = reinterpret_cast<int16_t*>(out.data());
+		callback_data.output_pointer = out;
 		callback_data.output_buffer_frames_remaining = frames;
 
 		/* Resample the decoded audio data. */
 		ClownResampler_HighLevel_Resample(&resampler, &precomputed, ResamplerInputCallback, ResamplerOutputCallback, &callback_data);
 
 		/* If there are no more samples left, then fill the remaining space in the buffer with 0. */
-		memset(callback_data.output_pointer, 0, callback_data.output_buffer_frames_remaining * 2 * sizeof(int16_t));
+		std::fill(callback_data.output_pointer, callback_data.output_pointer + callback_data.output_buffer_frames_remaining * 2, 0);
+
+		return frames;
+	}
+
+	uint32_t GetFrequency() const override
+	{
+		return frequency;
+	}
+};
 
-		return reinterpret_cast<const int16_t *>(out.data());
-	});
+// Game entry point
+static void Main()
+{
+	Core::Backend::Instance();
+	VFS::Backend::Instance();
+	Render::Backend::Instance();
+	auto &audio = Audio::Backend::Instance();
+	(void)audio;
+
+	try
+	{
+		xa_stream = std::make_unique<PS1::XAStream>("C:/Users/CKDEV/Documents/DuckStation/isos/rapper/Image/S2/STAGE2.XA1", std::vector<PS1::XAStream::ChannelID>{ { 1, 1 } });
+	}
+	catch (std::exception &e)
+	{
+		std::cout << "Failed to open XA stream: " << e.what() << std::endl;
+	}
+
+	ClownResampler_Precompute(&precomputed);
+	ClownResampler_HighLevel_Init(&resampler, 2, 37800, audio.GetFrequency(), 44100);
+
+	static MusicSource music_source(audio.GetFrequency());
+
+	auto &mixer = Audio::Mixer::Instance();
+	mixer.Play(music_source);
 
 	auto window = Render::Backend::Instance().window;
 	auto context = Render::Backend::Instance().context;
@@ -171,7 +173,7 @@ static void Main()
 	thread.Resume();
 	*/
 
-	// auto my_file = std::make_shared<MyFile>("C:/Users/CKDEV/Documents/DuckStation/isos/rapper/Image/S1/COMPO01.INT");
+	// auto my_file = std::make_shared<Types::MmapFile>("C:/Users/CKDEV/Documents/DuckStation/isos/rapper/Image/S1/COMPO01.INT", Types::MmapFile::Access_Random);
 	// INT::INT int_file(my_file);
 
 	/*
@@ -197,20 +199,18 @@ static void Main()
 		"KEYS.TMD",
 	};
 	
+	// Parse and build every model on the job backend, then only upload here
+	// Meshes that were built on a previous run are mapped from the cache instead
+	TMD::MeshCache mesh_cache(VFS::Backend::Instance().GetInstallDir() / "Cache" / "TMD");
+	auto tmd_prepared = TMD::Prepare(int_file, std::vector<std::string>(std::begin(names), std::end(names)), &mesh_cache);
+
 	auto tmd_models = std::make_unique<std::unique_ptr<TMD::Model>[]>(sizeof(names) / sizeof(names[0]));
 	for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++)
-	{
-		std::unique_ptr<Types::File> tmd_file(int_file.Open(names[i]));
-		auto tmd_data = std::make_shared<TMD::Data>(*tmd_file);
-		tmd_models[i] = std::make_unique<TMD::Model>(tmd_data);
-	}
+		tmd_models[i] = std::make_unique<TMD::Model>(tmd_prepared[i]);
 
 	PS1::Context ps1;
 	for (auto &i : int_file.TIMs())
-	{
-		std::unique_ptr<Types::File> tim_file(int_file.Open(i.c_str()));
-		ps1.LoadTIM(*tim_file);
-	}
+		ps1.LoadTIM(int_file.Open(i));
 
 	auto &shader = PS1::Shader::Instance();
 
@@ -249,7 +249,9 @@ static void Main()
 		// Enable backface culling
 		glEnable(GL_CULL_FACE);
 
-		// Bind vram texture
+		// Upload what was written to VRAM since last frame, then bind it
+		ps1.Flush();
+
 		glActiveTexture(GL_TEXTURE0);
 		glBindTexture(GL_TEXTURE_2D, ps1.vram_texture_id.Get());
 		glUniform1i(glGetUniformLocation(shader.shader.program.Get(), "u_vram"), 0);
@@ -2,6 +2,21 @@
 
 #include "Types/Exceptions.h"
 
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PAPERPUP_ADPCM_SSE2
+#include <emmintrin.h>
+
+#if defined(__GNUC__) || defined(__clang__) || defined(_MSC_VER)
+#define PAPERPUP_ADPCM_AVX2
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+#endif
+
 namespace PaperPup::PS1
 {
 
@@ -19,6 +34,109 @@ static const struct
 	{   0,   0 }
 };
 
+// XA sound unit unpacking
+// A sound group holds 28 little-endian words, with each sound unit taking one nibble or byte out of every word
+// Unpacking moves the unit's field to the top of the word, masks off the lower fields, then arithmetic shifts
+// it back down, which gives the same result as `(t << 12) >> shift` or `(t << 8) >> shift` on the sign extended field
+typedef void (*UnpackUnitFunc)(const char *word_p, unsigned int shl, uint32_t mask, unsigned int sar, int32_t *out);
+
+[[maybe_unused]] static void UnpackUnit_Scalar(const char *word_p, unsigned int shl, uint32_t mask, unsigned int sar, int32_t *out)
+{
+	for (size_t w = 0; w < 28; w++)
+	{
+		uint32_t word = 0;
+		word |= (static_cast<uint32_t>(word_p[0]) & 0xFF) << 0;
+		word |= (static_cast<uint32_t>(word_p[1]) & 0xFF) << 8;
+		word |= (static_cast<uint32_t>(word_p[2]) & 0xFF) << 16;
+		word |= (static_cast<uint32_t>(word_p[3]) & 0xFF) << 24;
+		word_p += 4;
+
+		*out++ = static_cast<int32_t>((word << shl) & mask) >> sar;
+	}
+}
+
+#ifdef PAPERPUP_ADPCM_SSE2
+static void UnpackUnit_SSE2(const char *word_p, unsigned int shl, uint32_t mask, unsigned int sar, int32_t *out)
+{
+	const __m128i shl_v = _mm_cvtsi32_si128(static_cast<int>(shl));
+	const __m128i sar_v = _mm_cvtsi32_si128(static_cast<int>(sar));
+	const __m128i mask_v = _mm_set1_epi32(static_cast<int>(mask));
+
+	for (size_t w = 0; w < 28; w += 4)
+	{
+		__m128i words = _mm_loadu_si128(reinterpret_cast<const __m128i *>(word_p + w * 4));
+		words = _mm_sra_epi32(_mm_and_si128(_mm_sll_epi32(words, shl_v), mask_v), sar_v);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(out + w), words);
+	}
+}
+#endif
+
+#ifdef PAPERPUP_ADPCM_AVX2
+#ifdef _MSC_VER
+#define PAPERPUP_TARGET_AVX2
+#else
+#define PAPERPUP_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+PAPERPUP_TARGET_AVX2 static void UnpackUnit_AVX2(const char *word_p, unsigned int shl, uint32_t mask, unsigned int sar, int32_t *out)
+{
+	const __m128i shl_v = _mm_cvtsi32_si128(static_cast<int>(shl));
+	const __m128i sar_v = _mm_cvtsi32_si128(static_cast<int>(sar));
+	const __m256i mask_v = _mm256_set1_epi32(static_cast<int>(mask));
+
+	// 24 words in 3 AVX2 vectors
+	for (size_t w = 0; w < 24; w += 8)
+	{
+		__m256i words = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(word_p + w * 4));
+		words = _mm256_sra_epi32(_mm256_and_si256(_mm256_sll_epi32(words, shl_v), mask_v), sar_v);
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(out + w), words);
+	}
+
+	// Last 4 words in an SSE2 vector
+	__m128i words = _mm_loadu_si128(reinterpret_cast<const __m128i *>(word_p + 24 * 4));
+	words = _mm_sra_epi32(_mm_and_si128(_mm_sll_epi32(words, shl_v), _mm256_castsi256_si128(mask_v)), sar_v);
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(out + 24), words);
+}
+
+static bool CPUSupportsAVX2()
+{
+#ifdef _MSC_VER
+	int info[4];
+
+	// Require OSXSAVE and AVX
+	__cpuid(info, 1);
+	if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0)
+		return false;
+
+	// Require the OS to save the YMM registers
+	if ((_xgetbv(0) & 0x6) != 0x6)
+		return false;
+
+	// Require AVX2
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+static UnpackUnitFunc SelectUnpackUnit()
+{
+#ifdef PAPERPUP_ADPCM_AVX2
+	if (CPUSupportsAVX2())
+		return UnpackUnit_AVX2;
+#endif
+#ifdef PAPERPUP_ADPCM_SSE2
+	return UnpackUnit_SSE2;
+#else
+	return UnpackUnit_Scalar;
+#endif
+}
+
+static const UnpackUnitFunc UnpackUnit = SelectUnpackUnit();
+
 int16_t ADPCMDecode::DecodeNibble(unsigned char nibble, unsigned char shift, char f0, char f1)
 {
 	// Sign extend nibble
@@ -61,6 +179,32 @@ int16_t ADPCMDecode::DecodeByte(unsigned char byte, unsigned char shift, char f0
 	return static_cast<int16_t>(s);
 }
 
+void ADPCMDecode::DecodeUnit(const int32_t *scaled, char f0, char f1, int16_t *out, size_t stride)
+{
+	// Keep the filter in registers for the whole unit
+	int32_t old = filter_old, older = filter_older;
+
+	for (size_t i = 0; i < 28; i++)
+	{
+		// Decode and clip sample
+		int32_t s = scaled[i] + ((f0 * old + f1 * older + 32) / 64);
+		if (s < -0x7FFF)
+			s = -0x7FFF;
+		if (s > 0x7FFF)
+			s = 0x7FFF;
+
+		// Update filter
+		older = old;
+		old = s;
+
+		*out = static_cast<int16_t>(s);
+		out += stride;
+	}
+
+	filter_old = old;
+	filter_older = older;
+}
+
 void ADPCMDecode::DecodeSPUBlock(Types::Span<const char, 16> block, Types::Span<int16_t, 28> out)
 {
 	unsigned char shift_filter = static_cast<unsigned char>(block[0]);
@@ -111,82 +255,49 @@ void XADecode::DecodeXAData(Types::Span<const char, 0x920> sector, XASectorOut &
 			return;
 		}
 
-		for (size_t b = 0; b < (Fmt8Bit ? 4 : 8); b += (FmtStereo ? 2 : 1))
-		{
-			// Read headers
-			unsigned char header_l, header_r;
+		// Decode sound units
+		const char *word_p = &sector[sector_p + 16];
 
-			unsigned char shift_l, shift_r;
-			char f0_l, f1_l, f0_r, f1_r;
+		constexpr unsigned int bits = Fmt8Bit ? 8 : 4;
+		constexpr uint32_t mask = ~0U << (32 - bits);
 
-			if constexpr (FmtStereo)
-			{
-				header_l = static_cast<unsigned char>(header[b + 0]);
-				header_r = static_cast<unsigned char>(header[b + 1]);
-			}
-			else
-			{
-				header_l = static_cast<unsigned char>(header[b]);
+		for (unsigned int b = 0; b < (Fmt8Bit ? 4 : 8); b += (FmtStereo ? 2 : 1))
+		{
+			int32_t scaled[28];
 
-				(void)header_r;
-			}
+			// Read headers
+			unsigned char header_l = static_cast<unsigned char>(header[b + 0]);
 
-			shift_l = header_l & 0x0F;
+			unsigned char shift_l = header_l & 0x0F;
 			if (shift_l > 12)
 				shift_l = 9;
 			unsigned char filter_l = (header_l >> 4) & 0x03;
-			f0_l = FILTERS[filter_l].f0;
-			f1_l = FILTERS[filter_l].f1;
+
+			// Decode left (or mono) unit
+			UnpackUnit(word_p, 32 - bits * (b + 1), mask, 16 + shift_l, scaled);
+			adpcm_l.DecodeUnit(scaled, FILTERS[filter_l].f0, FILTERS[filter_l].f1, out_p + 0, 2);
 
 			if constexpr (FmtStereo)
 			{
-				shift_r = header_r & 0x0F;
+				unsigned char header_r = static_cast<unsigned char>(header[b + 1]);
+
+				unsigned char shift_r = header_r & 0x0F;
 				if (shift_r > 12)
 					shift_r = 9;
 				unsigned char filter_r = (header_r >> 4) & 0x03;
-				f0_r = FILTERS[filter_r].f0;
-				f1_r = FILTERS[filter_r].f1;
+
+				// Decode right unit
+				UnpackUnit(word_p, 32 - bits * (b + 2), mask, 16 + shift_r, scaled);
+				adpcm_r.DecodeUnit(scaled, FILTERS[filter_r].f0, FILTERS[filter_r].f1, out_p + 1, 2);
 			}
 			else
 			{
-				(void)shift_r;
-				(void)f0_r;
-				(void)f1_r;
+				// Duplicate mono samples to the right channel
+				for (size_t w = 0; w < 28; w++)
+					out_p[w * 2 + 1] = out_p[w * 2 + 0];
 			}
 
-			// Decode sample words
-			auto *word_p = &sector[sector_p + 16];
-
-			for (size_t w = 0; w < 28; w++)
-			{
-				uint32_t word = 0;
-				word |= (static_cast<uint32_t>(word_p[0]) & 0xFF) << 0;
-				word |= (static_cast<uint32_t>(word_p[1]) & 0xFF) << 8;
-				word |= (static_cast<uint32_t>(word_p[2]) & 0xFF) << 16;
-				word |= (static_cast<uint32_t>(word_p[3]) & 0xFF) << 24;
-				word_p += 4;
-
-				int16_t sample_l, sample_r;
-				if constexpr (Fmt8Bit)
-				{
-					sample_l = adpcm_l.DecodeByte((word >> ((b + 0) * 8)) & 0xFF, shift_l, f0_l, f1_l);
-					if constexpr (FmtStereo)
-						sample_r = adpcm_r.DecodeByte((word >> ((b + 1) * 8)) & 0xFF, shift_r, f0_r, f1_r);
-					else
-						sample_r = sample_l;
-				}
-				else
-				{
-					sample_l = adpcm_l.DecodeNibble((word >> ((b + 0) * 4)) & 0xF, shift_l, f0_l, f1_l);
-					if constexpr (FmtStereo)
-						sample_r = adpcm_r.DecodeNibble((word >> ((b + 1) * 4)) & 0xF, shift_r, f0_r, f1_r);
-					else
-						sample_r = sample_l;
-				}
-
-				*out_p++ = sample_l;
-				*out_p++ = sample_r;
-			}
+			out_p += 28 * 2;
 		}
 
 		sector_p += 0x80;
@@ -20,15 +20,34 @@ private:
 	int32_t filter_old = 0, filter_older = 0;
 
 public:
+	struct State
+	{
+		int32_t filter_old, filter_older;
+	};
+
 	void Reset()
 	{
 		filter_old = 0;
 		filter_older = 0;
 	}
 
+	State GetState() const
+	{
+		return { filter_old, filter_older };
+	}
+
+	void SetState(const State &state)
+	{
+		filter_old = state.filter_old;
+		filter_older = state.filter_older;
+	}
+
 	int16_t DecodeNibble(unsigned char nibble, unsigned char shift, char f0, char f1);
 	int16_t DecodeByte(unsigned char byte, unsigned char shift, char f0, char f1);
 
+	// Filters a unit of 28 already shifted samples, writing every `stride`th output
+	void DecodeUnit(const int32_t *scaled, char f0, char f1, int16_t *out, size_t stride);
+
 	void DecodeSPUBlock(Types::Span<const char, 16> block, Types::Span<int16_t, 28> out);
 };
 
@@ -42,6 +61,11 @@ public:
 		std::array<int16_t[2], 28 * 8 * 0x12> samples;
 	};
 
+	struct State
+	{
+		ADPCMDecode::State l, r;
+	};
+
 private:
 	ADPCMDecode adpcm_l, adpcm_r;
 
@@ -55,6 +79,17 @@ public:
 		adpcm_r.Reset();
 	}
 
+	State GetState() const
+	{
+		return { adpcm_l.GetState(), adpcm_r.GetState() };
+	}
+
+	void SetState(const State &state)
+	{
+		adpcm_l.SetState(state.l);
+		adpcm_r.SetState(state.r);
+	}
+
 	void DecodeXASector(Types::Span<const char, 0x920> sector, XASectorOut &out);
 };
 
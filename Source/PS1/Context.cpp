@@ -2,21 +2,22 @@
 
 #include "PS1/TIM.h"
 
-#include "Util/Endian.h"
-
 #include "Types/Exceptions.h"
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 
 namespace PaperPup::PS1
 {
 
-Context::Context()
+Context::Context() : vram(std::make_unique<uint16_t[]>(VRAM_WIDTH * VRAM_HEIGHT))
 {
-	// Create 1024x512 VRAM texture (R16U)
+	// Create 1024x512 VRAM texture (R16U), starting out the same as the mirror
 	glGenTextures(1, vram_texture_id.GetAddressOf());
 	glBindTexture(GL_TEXTURE_2D, vram_texture_id.Get());
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_R16UI, 1024, 512, 0, GL_RED_INTEGER, GL_UNSIGNED_SHORT, nullptr);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R16UI, VRAM_WIDTH, VRAM_HEIGHT, 0, GL_RED_INTEGER, GL_UNSIGNED_SHORT, vram.get());
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 }
@@ -28,56 +29,108 @@ Context::~Context()
 
 void Context::LoadTIM(const Types::File &tim_file)
 {
-	glBindTexture(GL_TEXTURE_2D, vram_texture_id.Get());
-	glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
+	LoadTIM(TIM::Image(tim_file));
+}
 
-	const auto &tim_header = tim_file.Get<TIM::Header>(0);
+void Context::LoadTIM(const TIM::Image &image)
+{
+	for (size_t i = 0; i < image.rects_size; i++)
+	{
+		const auto &rect = image.rects[i];
+		if (rect.w == 0 || rect.h == 0)
+			continue;
 
-	if (Endian::SwapLE(tim_header.id) != 0x10)
-		throw Types::RuntimeException("Invalid TIM file");
+		for (size_t y = 0; y < rect.h; y++)
+			std::memcpy(vram.get() + (rect.y + y) * VRAM_WIDTH + rect.x, rect.pixels.Data() + y * rect.w, rect.w * sizeof(uint16_t));
 
-	const auto type = Endian::SwapLE(tim_header.type);
-	switch (type & TIM::Header::Type_BPP_Mask)
+		MarkDirty({ rect.x, rect.y, rect.w, rect.h });
+	}
+}
+
+void Context::MarkDirty(Rect rect)
+{
+	// Merging can make the rectangle touch ones it didn't before, so keep going until nothing's left to merge
+	bool merged = true;
+	while (merged)
 	{
-		case TIM::Header::Type_16Bit:
-		case TIM::Header::Type_4Bit:
-		case TIM::Header::Type_8Bit:
-		case TIM::Header::Type_24Bit:
-		case TIM::Header::Type_Mixed:
+		merged = false;
+		for (size_t i = 0; i < dirty.size(); i++)
+		{
+			const Rect &other = dirty[i];
+			if (rect.x > other.x + other.w || other.x > rect.x + rect.w || rect.y > other.y + other.h || other.y > rect.y + rect.h)
+				continue;
+
+			uint16_t x0 = std::min(rect.x, other.x);
+			uint16_t y0 = std::min(rect.y, other.y);
+			uint16_t x1 = std::max(rect.x + rect.w, other.x + other.w);
+			uint16_t y1 = std::max(rect.y + rect.h, other.y + other.h);
+			rect = { x0, y0, static_cast<uint16_t>(x1 - x0), static_cast<uint16_t>(y1 - y0) };
+
+			dirty[i] = dirty.back();
+			dirty.pop_back();
+			merged = true;
 			break;
-		default:
-			throw Types::RuntimeException("Unsupported TIM type");
+		}
 	}
 
-	size_t tim_p = sizeof(TIM::Header);
+	dirty.push_back(rect);
 
-	bool is_clut = (type & TIM::Header::Type_HasCLUT) != 0;
-	for (int i = is_clut; i-- >= 0;)
+	// Too many separate uploads cost more than uploading some clean pixels
+	if (dirty.size() > DIRTY_MAX)
 	{
-		const auto &image_header = tim_file.Get<TIM::ImageHeader>(tim_p);
+		Rect bounds = dirty.front();
+		uint16_t x1 = bounds.x + bounds.w, y1 = bounds.y + bounds.h;
+		for (auto &other : dirty)
+		{
+			bounds.x = std::min(bounds.x, other.x);
+			bounds.y = std::min(bounds.y, other.y);
+			x1 = std::max<uint16_t>(x1, other.x + other.w);
+			y1 = std::max<uint16_t>(y1, other.y + other.h);
+		}
+		bounds.w = x1 - bounds.x;
+		bounds.h = y1 - bounds.y;
+
+		dirty.assign(1, bounds);
+	}
+}
 
-		const auto size = Endian::SwapLE(image_header.size);
+void Context::Flush()
+{
+	flush_stats = {};
+	if (dirty.empty())
+		return;
 
-		const auto next_p = tim_p + size;
-		tim_p += sizeof(TIM::ImageHeader);
+	glBindTexture(GL_TEXTURE_2D, vram_texture_id.Get());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, VRAM_WIDTH);
 
-		const auto x = Endian::SwapLE(image_header.x);
-		const auto y = Endian::SwapLE(image_header.y);
-		const auto w = Endian::SwapLE(image_header.w);
-		const auto h = Endian::SwapLE(image_header.h);
+	for (auto &rect : dirty)
+	{
+		glTexSubImage2D(GL_TEXTURE_2D, 0, rect.x, rect.y, rect.w, rect.h, GL_RED_INTEGER, GL_UNSIGNED_SHORT, vram.get() + rect.y * VRAM_WIDTH + rect.x);
 
-		if (x + w > 1024 || y + h > 512)
-			throw Types::RuntimeException("TIM image out of bounds");
+		flush_stats.rects++;
+		flush_stats.pixels += static_cast<size_t>(rect.w) * rect.h;
+	}
 
-		size_t data_size = 2ULL * w * h;
-		if (data_size > (size + sizeof(TIM::ImageHeader)))
-			throw Types::RuntimeException("TIM image data out of bounds");
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+	dirty.clear();
+}
 
-		const auto data_span = tim_file.GetSubspan<uint16_t>(tim_p, data_size / 2);
-		glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, w, h, GL_RED_INTEGER, GL_UNSIGNED_SHORT, data_span.Data());
+const Context::FlushStats &Context::GetFlushStats() const
+{
+	return flush_stats;
+}
 
-		tim_p = next_p;
-	}
+Types::Span<const uint16_t> Context::GetVRAM() const
+{
+	return Types::Span<const uint16_t>(vram.get(), VRAM_WIDTH * VRAM_HEIGHT);
+}
+
+uint16_t Context::GetPixel(size_t x, size_t y) const
+{
+	if (x >= VRAM_WIDTH || y >= VRAM_HEIGHT)
+		throw Types::RuntimeException("VRAM pixel out of bounds");
+	return vram[y * VRAM_WIDTH + x];
 }
 
 }
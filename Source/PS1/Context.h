@@ -3,15 +3,49 @@
 #include "glad/glad.h"
 
 #include "Types/File.h"
+#include "Types/Span.h"
 #include "Types/UniqueGLInstance.h"
 
+#include "PS1/TIM.h"
+
+#include <cstdint>
 #include <memory>
+#include <vector>
 
 namespace PaperPup::PS1
 {
 
 class Context
 {
+public:
+	static constexpr size_t VRAM_WIDTH = 1024;
+	static constexpr size_t VRAM_HEIGHT = 512;
+
+	struct Rect
+	{
+		uint16_t x, y, w, h;
+	};
+
+	struct FlushStats
+	{
+		size_t rects;
+		size_t pixels;
+	};
+
+	// Dirty rectangles past this are merged into their bounding box
+	static constexpr size_t DIRTY_MAX = 16;
+
+private:
+	// CPU copy of VRAM, writes land here and reach the texture on Flush
+	std::unique_ptr<uint16_t[]> vram;
+
+	// Kept disjoint, rectangles that overlap or touch are merged as they're added
+	std::vector<Rect> dirty;
+
+	FlushStats flush_stats = {};
+
+	void MarkDirty(Rect rect);
+
 public:
 	// VRAM texture
 	Types::UniqueGLInstance<GLuint, decltype(glDeleteTextures), &glDeleteTextures, false> vram_texture_id;
@@ -20,6 +54,17 @@ public:
 	~Context();
 
 	void LoadTIM(const Types::File &tim_file);
+	void LoadTIM(const TIM::Image &image);
+
+	// Uploads the dirty rectangles to the texture, meant to be called once per frame before drawing
+	void Flush();
+	const FlushStats &GetFlushStats() const;
+
+	// Row-major VRAM_WIDTH by VRAM_HEIGHT, up to date with every write even before it's flushed
+	Types::Span<const uint16_t> GetVRAM() const;
+
+	// Throws if the pixel is outside of VRAM
+	uint16_t GetPixel(size_t x, size_t y) const;
 };
 
 }
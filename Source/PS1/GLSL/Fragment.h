@@ -6,7 +6,9 @@ out vec4 o_color;
 uniform usampler2D u_vram;
 
 in vec2 v_uv;
+in vec3 v_color;
 flat in uint v_clut;
+flat in uint v_flags;
 
 vec4 RGBA5551ToRGBA8(uint v)
 {
@@ -20,16 +22,48 @@ vec4 RGBA5551ToRGBA8(uint v)
 
 void main()
 {
+	// Untextured primitives only have their colour
+	if ((v_flags & 1u) == 0u)
+	{
+		o_color = vec4(v_color * 0.5, 1.0);
+		return;
+	}
+
 	uvec2 tex_coord = uvec2(v_uv);
-	ivec2 texel_coord = ivec2(v_uv.x / 4u, v_uv.y);
-	uint texel = texelFetch(u_vram, texel_coord, 0).r;
-	uint nibble = (texel >> ((tex_coord.x & 3u) << 2u)) & 0xFu;
+	uint depth = (v_flags >> 1u) & 3u;
+
+	uint clut_texel;
+	if (depth == 0u)
+	{
+		// 4-bit, 4 texels per VRAM pixel
+		ivec2 texel_coord = ivec2(tex_coord.x >> 2u, tex_coord.y);
+		uint texel = texelFetch(u_vram, texel_coord, 0).r;
+		uint index = (texel >> ((tex_coord.x & 3u) << 2u)) & 0xFu;
 
-	ivec2 clut_coord = ivec2(((v_clut & 0x3Fu) << 4u) + nibble, v_clut >> 6u);
-	uint clut_texel = texelFetch(u_vram, clut_coord, 0).r;
+		ivec2 clut_coord = ivec2(((v_clut & 0x3Fu) << 4u) + index, v_clut >> 6u);
+		clut_texel = texelFetch(u_vram, clut_coord, 0).r;
+	}
+	else if (depth == 1u)
+	{
+		// 8-bit, 2 texels per VRAM pixel
+		ivec2 texel_coord = ivec2(tex_coord.x >> 1u, tex_coord.y);
+		uint texel = texelFetch(u_vram, texel_coord, 0).r;
+		uint index = (texel >> ((tex_coord.x & 1u) << 3u)) & 0xFFu;
+
+		ivec2 clut_coord = ivec2(((v_clut & 0x3Fu) << 4u) + index, v_clut >> 6u);
+		clut_texel = texelFetch(u_vram, clut_coord, 0).r;
+	}
+	else
+	{
+		// 15-bit direct colour
+		clut_texel = texelFetch(u_vram, ivec2(tex_coord), 0).r;
+	}
 
 	if (clut_texel == 0u)
 		discard;
+
+	// Colours modulate textures with 128 as 1.0
 	o_color = RGBA5551ToRGBA8(clut_texel);
+	o_color.rgb = min(o_color.rgb * v_color, vec3(1.0));
 }
 )"
@@ -1,5 +1,8 @@
 #include "PS1/INT.h"
 
+#include <bit>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 
 namespace PaperPup::INT
@@ -12,6 +15,9 @@ INT::INT(const std::shared_ptr<PaperPup::Types::File> &_file) : file(_file)
 	// Read INT data
 	Types::Span<char> data = _file->GetSpan(4);
 
+	// Entries of TIM and VAB blocks are tracked since those are loaded automatically
+	std::vector<std::pair<uint32_t, size_t>> types;
+
 	while (1)
 	{
 		// Read new block
@@ -39,18 +45,13 @@ INT::INT(const std::shared_ptr<PaperPup::Types::File> &_file) : file(_file)
 			if (offset + entry->size > block_end)
 				throw Types::RuntimeException("INT file exceeds end of block");
 
-			// Get string form of entry name
-			char name[sizeof(entry->name) + 1];
-			memcpy(name, entry->name, sizeof(entry->name));
-			name[sizeof(entry->name)] = '\0';
-
-			std::string name_string = name;
+			// Copy entry name, which is padded with zeroes
+			Entry &new_entry = entries.emplace_back();
+			std::memcpy(new_entry.name, entry->name, sizeof(entry->name));
+			new_entry.name_size = static_cast<uint8_t>(strnlen(entry->name, sizeof(entry->name)));
+			new_entry.span = Types::Span<char>(data.Data() + offset, entry->size);
 
-			// Insert file span
-			// Track TIMs here since those are loaded automatically
-			if (block->type == BlockHeader::Type::Type_TIM)
-				tims.emplace_back(name_string);
-			spans.emplace(name_string, Types::Span<char>(data.Data() + offset, entry->size));
+			types.emplace_back(block->type, entries.size() - 1);
 
 			// Increment offset, ensure 4-byte alignment
 			offset += entry->size;
@@ -60,28 +61,170 @@ INT::INT(const std::shared_ptr<PaperPup::Types::File> &_file) : file(_file)
 
 		data = data.Slice(block_end);
 	}
+
+	// Build the table, kept at most half full
+	if (entries.size() >= 0x80000000)
+		throw Types::RuntimeException("INT contains too many files");
+
+	table.assign(std::bit_ceil(std::max<size_t>(entries.size() * 2, 16)), 0);
+	mask = table.size() - 1;
+
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		// Later entries with the same name are shadowed by the first, like they were before
+		std::string_view name = entries[i].Name();
+		if (Find(name) != nullptr)
+			continue;
+
+		size_t slot = Hash(name) & mask;
+		while (table[slot] != 0)
+			slot = (slot + 1) & mask;
+		table[slot] = static_cast<uint32_t>(i + 1);
+	}
+
+	for (auto &[type, i] : types)
+	{
+		if (type == BlockHeader::Type::Type_TIM)
+			tims.emplace_back(entries[i].Name());
+		else if (type == BlockHeader::Type::Type_VAB)
+			vabs.emplace_back(entries[i].Name());
+	}
 }
 
 INT::~INT()
 {
-
+	// Open members would be left pointing at freed data
+	if (pins != 0)
+	{
+		std::cerr << "INT destroyed with " << pins << " members still open" << std::endl;
+		std::abort();
+	}
 }
 
-bool INT::Contains(const char *name) const
+uint64_t INT::Hash(std::string_view name)
 {
-	return spans.contains(name);
+	// Names are at most 16 bytes, so they're hashed as two words
+	uint64_t words[2] = {};
+	std::memcpy(words, name.data(), std::min(name.size(), sizeof(words)));
+
+	uint64_t hash = (words[0] ^ (name.size() * 0x9E3779B97F4A7C15ULL)) * 0xBF58476D1CE4E5B9ULL;
+	hash = (hash ^ (hash >> 31) ^ words[1]) * 0x94D049BB133111EBULL;
+	return hash ^ (hash >> 29);
 }
 
-File *INT::Open(const char *name) const
+const INT::Entry *INT::Find(std::string_view name) const
 {
-	if (spans.contains(name))
-		return new File(file, spans.at(name));
+	if (name.size() > sizeof(FileEntry::name))
+		return nullptr;
+
+	size_t slot = Hash(name) & mask;
+	while (table[slot] != 0)
+	{
+		const Entry &entry = entries[table[slot] - 1];
+		if (entry.Name() == name)
+			return &entry;
+		slot = (slot + 1) & mask;
+	}
 	return nullptr;
 }
 
-const std::vector<std::string> &INT::TIMs() const
+bool INT::Contains(std::string_view name) const
+{
+	return Find(name) != nullptr;
+}
+
+Member INT::Open(std::string_view name) const
+{
+	if (const Entry *entry = Find(name))
+		return Member(*this, entry->span);
+	return Member();
+}
+
+const std::vector<std::string_view> &INT::TIMs() const
 {
 	return tims;
 }
 
+const std::vector<std::string_view> &INT::VABs() const
+{
+	return vabs;
+}
+
+// Member
+Member::Member(const INT &_archive, Types::Span<char> _span) : PaperPup::Types::File(_span), archive(&_archive)
+{
+	Pin();
+}
+
+Member::Member(const Member &other) : PaperPup::Types::File(other.span), archive(other.archive)
+{
+	Pin();
+}
+
+Member::Member(Member &&other) noexcept : PaperPup::Types::File(other.span), archive(other.archive)
+{
+	// The pin moves over with the archive
+	other.span = Types::Span<char>();
+	other.archive = nullptr;
+}
+
+Member::~Member()
+{
+	Unpin();
+}
+
+Member &Member::operator=(const Member &other)
+{
+	if (this != &other)
+	{
+		Unpin();
+		span = other.span;
+		archive = other.archive;
+		Pin();
+	}
+	return *this;
+}
+
+Member &Member::operator=(Member &&other) noexcept
+{
+	if (this != &other)
+	{
+		Unpin();
+		span = other.span;
+		archive = other.archive;
+		other.span = Types::Span<char>();
+		other.archive = nullptr;
+	}
+	return *this;
+}
+
+void INT::CheckOwner() const
+{
+#ifndef NDEBUG
+	if (std::this_thread::get_id() != owner)
+	{
+		std::cerr << "INT member pinned off the thread that owns the INT" << std::endl;
+		std::abort();
+	}
+#endif
+}
+
+void Member::Pin()
+{
+	if (archive != nullptr)
+	{
+		archive->CheckOwner();
+		archive->pins++;
+	}
+}
+
+void Member::Unpin()
+{
+	if (archive != nullptr)
+	{
+		archive->CheckOwner();
+		archive->pins--;
+	}
+}
+
 }
@@ -4,7 +4,8 @@
 
 #include <cstdint>
 #include <memory>
-#include <unordered_map>
+#include <string_view>
+#include <thread>
 #include <vector>
 
 #include "Types/File.h"
@@ -47,13 +48,35 @@ static_assert(alignof(FileEntry) <= 4);
 class INT;
 
 // INT classes
-class File : public PaperPup::Types::File
+// View of a file inside an INT, cheap enough to pass around by value
+// Pins the INT rather than owning a reference to its data, so the INT must outlive every member opened from it
+// The pin isn't atomic, so members must be opened, copied and destroyed on the thread that owns the INT
+class Member : public PaperPup::Types::File
 {
 private:
-	std::shared_ptr<PaperPup::Types::File> file;
+	const INT *archive = nullptr;
 
 	friend INT;
-	File(const std::shared_ptr<PaperPup::Types::File> &_file, Types::Span<char> _span) : PaperPup::Types::File(_span), file(_file) {}
+	Member(const INT &_archive, Types::Span<char> _span);
+
+	void Pin();
+	void Unpin();
+
+public:
+	// Empty, for names that aren't in the INT
+	Member() : PaperPup::Types::File(Types::Span<char>()) {}
+
+	Member(const Member &other);
+	Member(Member &&other) noexcept;
+	~Member() override;
+
+	Member &operator=(const Member &other);
+	Member &operator=(Member &&other) noexcept;
+
+	explicit operator bool() const
+	{
+		return archive != nullptr;
+	}
 };
 
 class INT
@@ -61,17 +84,51 @@ class INT
 private:
 	std::shared_ptr<PaperPup::Types::File> file;
 
-	std::unordered_map<std::string, Types::Span<char>> spans;
-	std::vector<std::string> tims;
+	// Directory, built once and never resized after
+	struct Entry
+	{
+		char name[sizeof(FileEntry::name)]; // Not terminated when it's the full 16 characters
+		uint8_t name_size;
+		Types::Span<char> span;
+
+		std::string_view Name() const
+		{
+			return std::string_view(name, name_size);
+		}
+	};
+	std::vector<Entry> entries;
+
+	// Open addressing table over the entries, entry index + 1 or 0 if empty
+	std::vector<uint32_t> table;
+	size_t mask = 0;
+
+	std::vector<std::string_view> tims;
+	std::vector<std::string_view> vabs;
+
+	// Members currently open
+	friend Member;
+	mutable uint32_t pins = 0;
+
+#ifndef NDEBUG
+	// Thread the INT was made on, the only one pins may be touched from
+	std::thread::id owner = std::this_thread::get_id();
+#endif
+	void CheckOwner() const;
+
+	static uint64_t Hash(std::string_view name);
+	const Entry *Find(std::string_view name) const;
 
 public:
 	INT(const std::shared_ptr<PaperPup::Types::File> &_file);
 	~INT();
 
-	bool Contains(const char *name) const;
-	File *Open(const char *name) const;
+	bool Contains(std::string_view name) const;
+	// Returns an empty member if the name isn't in the INT
+	Member Open(std::string_view name) const;
 
-	const std::vector<std::string> &TIMs() const;
+	// Names point into the directory, so they live as long as the INT
+	const std::vector<std::string_view> &TIMs() const;
+	const std::vector<std::string_view> &VABs() const;
 };
 
 }
@@ -0,0 +1,233 @@
+#include "PS1/INTLoader.h"
+
+#include "Backend/Jobs.h"
+
+namespace PaperPup::INT
+{
+
+Loader::Loader(const INT &_int_file, PS1::Context &_context, TMD::MeshCache *_mesh_cache) : int_file(_int_file), context(_context), mesh_cache(_mesh_cache)
+{
+
+}
+
+Loader::~Loader()
+{
+	// Workers still hold on to their tasks' members and products
+	std::unique_lock<std::mutex> lock(mutex);
+	idle.wait(lock, [this]() { return outstanding == 0; });
+
+	// Anything that never got uploaded fails, so its handle doesn't wait forever
+	for (auto &task : ready)
+		task->fail(task->error != nullptr ? task->error : std::make_exception_ptr(Types::RuntimeException("Loader destroyed")));
+	ready.clear();
+}
+
+template <typename T>
+Loader::Handle<T> Loader::NewHandle(Task &task)
+{
+	Handle<T> handle;
+	handle.slot = std::make_shared<typename Handle<T>::Slot>();
+
+	task.fail = [slot = handle.slot](std::exception_ptr error)
+	{
+		slot->error = error;
+		slot->done = true;
+	};
+	return handle;
+}
+
+Member Loader::OpenMember(std::string_view name) const
+{
+	Member member = int_file.Open(name);
+	if (!member)
+		throw Types::RuntimeException("Member not found in INT");
+	return member;
+}
+
+void Loader::Submit(std::shared_ptr<Task> task)
+{
+	progress.total++;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		outstanding++;
+	}
+
+	Jobs::Backend::Instance().Submit([this, task = std::move(task)]() mutable
+	{
+		try
+		{
+			task->parse();
+		}
+		catch (...)
+		{
+			task->error = std::current_exception();
+		}
+
+		// Moved out, so the job doesn't keep the task's members pinned after the loader is gone
+		// Notified under the lock, so the loader can't be destroyed before this is done with it
+		std::lock_guard<std::mutex> lock(mutex);
+		ready.push_back(std::move(task));
+		if (--outstanding == 0)
+			idle.notify_all();
+	});
+}
+
+std::unique_ptr<Loader::Rects> Loader::UploadImages(const std::vector<TIM::Image> &images)
+{
+	auto rects = std::make_unique<Rects>();
+	for (auto &image : images)
+	{
+		context.LoadTIM(image);
+		for (size_t i = 0; i < image.rects_size; i++)
+			rects->push_back({ image.rects[i].x, image.rects[i].y, image.rects[i].w, image.rects[i].h });
+	}
+	return rects;
+}
+
+Loader::Handle<Loader::Rects> Loader::LoadTIM(std::string_view name)
+{
+	auto task = std::make_shared<Task>();
+	task->members.push_back(OpenMember(name));
+
+	auto handle = NewHandle<Rects>(*task);
+	const Member &tim_file = task->members.front();
+
+	// The image goes away with the task, along with the member it points into
+	auto images = std::make_shared<std::vector<TIM::Image>>();
+	task->parse = [images, &tim_file]()
+	{
+		images->emplace_back(tim_file);
+	};
+	task->upload = [this, slot = handle.slot, images]()
+	{
+		slot->product = UploadImages(*images);
+		slot->done = true;
+	};
+
+	Submit(std::move(task));
+	return handle;
+}
+
+Loader::Handle<Loader::Rects> Loader::LoadTIMs()
+{
+	auto task = std::make_shared<Task>();
+	for (auto &name : int_file.TIMs())
+		task->members.push_back(OpenMember(name));
+
+	auto handle = NewHandle<Rects>(*task);
+	const auto &tim_files = task->members;
+
+	auto images = std::make_shared<std::vector<TIM::Image>>();
+	task->parse = [images, &tim_files]()
+	{
+		for (auto &tim_file : tim_files)
+			images->emplace_back(tim_file);
+	};
+	task->upload = [this, slot = handle.slot, images]()
+	{
+		slot->product = UploadImages(*images);
+		slot->done = true;
+	};
+
+	Submit(std::move(task));
+	return handle;
+}
+
+Loader::Handle<TMD::Model> Loader::LoadTMD(std::string_view name)
+{
+	auto task = std::make_shared<Task>();
+	task->members.push_back(OpenMember(name));
+
+	auto handle = NewHandle<TMD::Model>(*task);
+	const Member &tmd_file = task->members.front();
+
+	// Only the buffers are made on the render thread
+	auto prepared = std::make_shared<TMD::Prepared>();
+	task->parse = [mesh_cache = mesh_cache, prepared, &tmd_file]()
+	{
+		*prepared = TMD::Prepare(tmd_file, mesh_cache);
+	};
+	task->upload = [slot = handle.slot, prepared]()
+	{
+		slot->product = std::make_unique<TMD::Model>(*prepared);
+		slot->done = true;
+	};
+
+	Submit(std::move(task));
+	return handle;
+}
+
+Loader::Handle<VAB::Bank> Loader::LoadVABs()
+{
+	auto task = std::make_shared<Task>();
+	for (auto &name : int_file.VABs())
+		task->members.push_back(OpenMember(name));
+
+	auto handle = NewHandle<VAB::Bank>(*task);
+	const auto &vab_files = task->members;
+
+	// Nothing to upload, the bank is finished on the worker
+	task->parse = [slot = handle.slot, &vab_files]()
+	{
+		std::vector<std::shared_ptr<VAB::Data>> vabs;
+		for (auto &vab_file : vab_files)
+			vabs.emplace_back(std::make_shared<VAB::Data>(vab_file));
+		slot->product = std::make_unique<VAB::Bank>(std::move(vabs));
+	};
+	task->upload = [slot = handle.slot]()
+	{
+		slot->done = true;
+	};
+
+	Submit(std::move(task));
+	return handle;
+}
+
+void Loader::Update(std::chrono::microseconds budget)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	while (1)
+	{
+		std::shared_ptr<Task> task;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (ready.empty())
+				break;
+			task = std::move(ready.front());
+			ready.pop_front();
+		}
+
+		if (task->error)
+		{
+			task->fail(task->error);
+		}
+		else
+		{
+			try
+			{
+				task->upload();
+			}
+			catch (...)
+			{
+				task->fail(std::current_exception());
+			}
+		}
+		progress.done++;
+
+		if (std::chrono::steady_clock::now() - start >= budget)
+			break;
+	}
+}
+
+Loader::Progress Loader::GetProgress() const
+{
+	return progress;
+}
+
+bool Loader::Done() const
+{
+	return progress.done == progress.total;
+}
+
+}
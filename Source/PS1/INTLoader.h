@@ -0,0 +1,145 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+#include "Types/Exceptions.h"
+
+#include "PS1/Context.h"
+#include "PS1/INT.h"
+#include "PS1/TIM.h"
+#include "PS1/TMDCache.h"
+#include "PS1/TMDModel.h"
+#include "PS1/VAB.h"
+
+namespace PaperPup::INT
+{
+
+// Loads the contents of an INT in the background
+// Members are parsed on the job backend into CPU side products, which are then uploaded a few at a time by Update
+// Everything but the workers runs on the render thread, which must also own the INT
+class Loader
+{
+public:
+	// Result of one load, filled in by Update
+	template <typename T>
+	class Handle
+	{
+	private:
+		struct Slot
+		{
+			std::unique_ptr<T> product;
+			std::exception_ptr error;
+			bool done = false;
+		};
+		std::shared_ptr<Slot> slot;
+
+		friend Loader;
+
+	public:
+		Handle() = default;
+
+		// Whether the load finished, successfully or not
+		bool Ready() const
+		{
+			return slot != nullptr && slot->done;
+		}
+
+		bool Failed() const
+		{
+			return Ready() && slot->error != nullptr;
+		}
+
+		// Throws if the load hasn't finished, or rethrows what made it fail
+		T &Get() const
+		{
+			if (!Ready())
+				throw Types::RuntimeException("Asset isn't loaded yet");
+			if (slot->error)
+				std::rethrow_exception(slot->error);
+			return *slot->product;
+		}
+	};
+
+	// VRAM rectangles filled by a TIM load
+	// Parsed images point into their members, so they're dropped once uploaded rather than handed out
+	using Rects = std::vector<PS1::Context::Rect>;
+
+	struct Progress
+	{
+		size_t done;
+		size_t total;
+
+		float Fraction() const
+		{
+			return total != 0 ? static_cast<float>(done) / static_cast<float>(total) : 1.0f;
+		}
+	};
+
+private:
+	const INT &int_file;
+	PS1::Context &context;
+	TMD::MeshCache *mesh_cache;
+
+	struct Task
+	{
+		// Released on the render thread once the task is done, since their pins aren't atomic
+		std::vector<Member> members;
+
+		std::function<void()> parse; // On a worker
+		std::function<void()> upload; // On the render thread
+		std::function<void(std::exception_ptr)> fail;
+
+		std::exception_ptr error;
+	};
+
+	// Tasks that are parsed and waiting to be uploaded, and the number still on the workers
+	std::mutex mutex;
+	std::condition_variable idle;
+	std::deque<std::shared_ptr<Task>> ready;
+	size_t outstanding = 0;
+
+	Progress progress = {};
+
+	template <typename T>
+	Handle<T> NewHandle(Task &task);
+
+	Member OpenMember(std::string_view name) const;
+	void Submit(std::shared_ptr<Task> task);
+
+	std::unique_ptr<Rects> UploadImages(const std::vector<TIM::Image> &images);
+
+public:
+	Loader(const INT &_int_file, PS1::Context &_context, TMD::MeshCache *_mesh_cache = nullptr);
+	// Waits for the workers, then fails every load that wasn't uploaded yet
+	~Loader();
+
+	Loader(const Loader&) = delete;
+	Loader &operator=(const Loader&) = delete;
+
+	// Each of these throws straight away if a member isn't in the INT, anything else goes to the handle
+	Handle<Rects> LoadTIM(std::string_view name);
+	Handle<TMD::Model> LoadTMD(std::string_view name);
+	Handle<VAB::Bank> LoadVABs();
+
+	// Every TIM of the INT, as one handle since they only matter all together
+	Handle<Rects> LoadTIMs();
+
+	// Uploads parsed tasks until `budget` has passed, always finishing at least one if there is one
+	void Update(std::chrono::microseconds budget);
+
+	Progress GetProgress() const;
+
+	// Whether every load so far has finished
+	bool Done() const;
+};
+
+}
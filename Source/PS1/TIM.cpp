@@ -1,6 +1,62 @@
 #include "PS1/TIM.h"
 
+#include "Util/Endian.h"
+
+#include "Types/Exceptions.h"
+
 namespace PaperPup::TIM
 {
 
+Image::Image(const Types::File &tim_file)
+{
+	const auto &tim_header = tim_file.Get<Header>(0);
+
+	if (Endian::SwapLE(tim_header.id) != 0x10)
+		throw Types::RuntimeException("Invalid TIM file");
+
+	const auto type = Endian::SwapLE(tim_header.type);
+	switch (type & Header::Type_BPP_Mask)
+	{
+		case Header::Type_16Bit:
+		case Header::Type_4Bit:
+		case Header::Type_8Bit:
+		case Header::Type_24Bit:
+		case Header::Type_Mixed:
+			break;
+		default:
+			throw Types::RuntimeException("Unsupported TIM type");
+	}
+
+	size_t tim_p = sizeof(Header);
+
+	bool is_clut = (type & Header::Type_HasCLUT) != 0;
+	for (int i = is_clut; i-- >= 0;)
+	{
+		const auto &image_header = tim_file.Get<ImageHeader>(tim_p);
+
+		const auto size = Endian::SwapLE(image_header.size);
+
+		const auto next_p = tim_p + size;
+		tim_p += sizeof(ImageHeader);
+
+		Rect &rect = rects[rects_size++];
+		rect.x = Endian::SwapLE(image_header.x);
+		rect.y = Endian::SwapLE(image_header.y);
+		rect.w = Endian::SwapLE(image_header.w);
+		rect.h = Endian::SwapLE(image_header.h);
+
+		if (rect.x + rect.w > 1024 || rect.y + rect.h > 512)
+			throw Types::RuntimeException("TIM image out of bounds");
+
+		size_t data_size = 2ULL * rect.w * rect.h;
+		if (data_size > (size + sizeof(ImageHeader)))
+			throw Types::RuntimeException("TIM image data out of bounds");
+
+		auto data_span = tim_file.GetSubspan<uint16_t>(tim_p, data_size / 2);
+		rect.pixels = Types::Span<const uint16_t>(data_span.Data(), data_span.Size());
+
+		tim_p = next_p;
+	}
+}
+
 }
@@ -2,6 +2,9 @@
 
 #include <cstdint>
 
+#include "Types/File.h"
+#include "Types/Span.h"
+
 namespace PaperPup::TIM
 {
 
@@ -36,4 +39,20 @@ struct ImageHeader
 static_assert(sizeof(ImageHeader) == 12);
 static_assert(alignof(ImageHeader) <= 4);
 
+// Parsed TIM, as the VRAM rectangles it fills
+// Pixels point into the TIM file, so it has to outlive the image
+struct Image
+{
+	struct Rect
+	{
+		uint16_t x, y, w, h;
+		Types::Span<const uint16_t> pixels;
+	};
+	Rect rects[2]; // CLUT first if there is one
+	size_t rects_size = 0;
+
+	// Checks the TIM and that every rectangle fits in VRAM, doesn't need GL
+	Image(const Types::File &tim_file);
+};
+
 }
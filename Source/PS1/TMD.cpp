@@ -1,9 +1,8 @@
 #include "PS1/TMD.h"
 
 #include "Util/Endian.h"
-#include <iostream>
 
-#include <vector>
+#include <algorithm>
 
 namespace PaperPup::TMD
 {
@@ -95,238 +94,4 @@ Data::Data(const Types::File &tmd_file)
 	}
 }
 
-// TMD model object
-Model::Object::Object()
-{
-	glGenVertexArrays(1, vao_id.GetAddressOf());
-	glGenBuffers(1, vbo_id.GetAddressOf());
-	glGenBuffers(1, ebo_id.GetAddressOf());
-}
-
-void Model::Object::InitMesh(const Data::Object &object)
-{
-	std::vector<Vertex> vertices;
-	std::vector<uint16_t> indices;
-
-	auto add_vertex = [&vertices](const Vertex &vertex) -> uint16_t
-	{
-		for (size_t i = 0; i < vertices.size(); i++)
-		{
-			if (vertices[i] == vertex)
-				return static_cast<uint16_t>(i);
-		}
-
-		size_t i = vertices.size();
-		vertices.push_back(vertex);
-		return static_cast<uint16_t>(i);
-	};
-
-	const auto *vertex_p = object.vertex_p;
-	const auto *primitive_p = object.primitive_p;
-	for (size_t p = 0; p < object.primitive_size; p++)
-	{
-		const auto &primitive_header = *reinterpret_cast<const PrimitiveHeader *>(primitive_p);
-
-		// const auto primitive_flags = primitive_header.Flags();
-		const auto primitive_mode = primitive_header.Mode();
-
-		const auto primitive_kind = primitive_mode & PrimitiveHeader::Mode_Kind_Mask;
-		if (primitive_kind == PrimitiveHeader::Mode_Kind_Poly)
-		{
-			if (primitive_mode & PrimitiveHeader::Mode_Quad)
-			{
-				if (primitive_mode & PrimitiveHeader::Mode_NoLight)
-				{
-					if (primitive_mode & PrimitiveHeader::Mode_Textured)
-					{
-						if (primitive_mode & PrimitiveHeader::Mode_Gouraud)
-						{
-
-						}
-						else
-						{
-							const auto &uv0 = *reinterpret_cast<const PrimitiveUV *>(&primitive_p[1]);
-							const auto &uv1 = *reinterpret_cast<const PrimitiveUV *>(&primitive_p[2]);
-							const auto &uv2 = *reinterpret_cast<const PrimitiveUV *>(&primitive_p[3]);
-							const auto &uv3 = *reinterpret_cast<const PrimitiveUV *>(&primitive_p[4]);
-							const auto &rgb = *reinterpret_cast<const PrimitiveRGB *>(&primitive_p[5]);
-							const auto &v10 = *reinterpret_cast<const PrimitivePair *>(&primitive_p[6]);
-							const auto &v32 = *reinterpret_cast<const PrimitivePair *>(&primitive_p[7]);
-
-							const auto i0 = v10.Right();
-							const auto i1 = v10.Left();
-							const auto i2 = v32.Right();
-							const auto i3 = v32.Left();
-
-							const auto &v0 = vertex_p[i0];
-							const auto &v1 = vertex_p[i1];
-							const auto &v2 = vertex_p[i2];
-							const auto &v3 = vertex_p[i3];
-
-							const auto clut = uv0.CLUT();
-							const auto tpage = uv1.TPage();
-
-							auto tpu = static_cast<uint16_t>(64 * tpage.X());
-							switch (tpage.Depth())
-							{
-								case BitDepth_4Bit:
-									tpu *= 4;
-									break;
-								case BitDepth_8Bit:
-									tpu *= 2;
-									break;
-								case BitDepth_15Bit:
-									break;
-							}
-
-							const auto tpv = static_cast<uint16_t>(256 * tpage.Y());
-
-							Vertex vertex0 = { { v0.x, v0.y, v0.z }, { 0, 0, 0, static_cast<uint16_t>(tpu + uv0.U()), static_cast<uint16_t>(tpv + uv0.V()), std::bit_cast<uint16_t>(clut), rgb.R(), rgb.G(), rgb.B(), 0 } };
-							Vertex vertex1 = { { v1.x, v1.y, v1.z }, { 0, 0, 0, static_cast<uint16_t>(tpu + uv1.U()), static_cast<uint16_t>(tpv + uv1.V()), std::bit_cast<uint16_t>(clut), rgb.R(), rgb.G(), rgb.B(), 0 } };
-							Vertex vertex2 = { { v2.x, v2.y, v2.z }, { 0, 0, 0, static_cast<uint16_t>(tpu + uv2.U()), static_cast<uint16_t>(tpv + uv2.V()), std::bit_cast<uint16_t>(clut), rgb.R(), rgb.G(), rgb.B(), 0 } };
-							Vertex vertex3 = { { v3.x, v3.y, v3.z }, { 0, 0, 0, static_cast<uint16_t>(tpu + uv3.U()), static_cast<uint16_t>(tpv + uv3.V()), std::bit_cast<uint16_t>(clut), rgb.R(), rgb.G(), rgb.B(), 0 } };
-
-							const auto vi0 = add_vertex(vertex0);
-							const auto vi1 = add_vertex(vertex1);
-							const auto vi2 = add_vertex(vertex2);
-							const auto vi3 = add_vertex(vertex3);
-
-							vertex_indices.push_back(i2);
-							indices.push_back(vi2);
-
-							vertex_indices.push_back(i1);
-							indices.push_back(vi1);
-
-							vertex_indices.push_back(i0);
-							indices.push_back(vi0);
-
-							vertex_indices.push_back(i1);
-							indices.push_back(vi1);
-
-							vertex_indices.push_back(i2);
-							indices.push_back(vi2);
-
-							vertex_indices.push_back(i3);
-							indices.push_back(vi3);
-						}
-					}
-				}
-			}
-			else
-			{
-				if (primitive_mode & PrimitiveHeader::Mode_NoLight)
-				{
-					if (primitive_mode & PrimitiveHeader::Mode_Textured)
-					{
-						if (primitive_mode & PrimitiveHeader::Mode_Gouraud)
-						{
-							
-						}
-						else
-						{
-							const auto &uv0 = *reinterpret_cast<const PrimitiveUV *>(&primitive_p[1]);
-							const auto &uv1 = *reinterpret_cast<const PrimitiveUV *>(&primitive_p[2]);
-							const auto &uv2 = *reinterpret_cast<const PrimitiveUV *>(&primitive_p[3]);
-							const auto &rgb = *reinterpret_cast<const PrimitiveRGB *>(&primitive_p[4]);
-							const auto &v10 = *reinterpret_cast<const PrimitivePair *>(&primitive_p[5]);
-							const auto &v_2 = *reinterpret_cast<const PrimitivePair *>(&primitive_p[6]);
-
-							const auto i0 = v10.Right();
-							const auto i1 = v10.Left();
-							const auto i2 = v_2.Right();
-
-							const auto &v0 = vertex_p[i0];
-							const auto &v1 = vertex_p[i1];
-							const auto &v2 = vertex_p[i2];
-
-							const auto clut = uv0.CLUT();
-							const auto tpage = uv1.TPage();
-
-							auto tpu = static_cast<uint16_t>(64 * tpage.X());
-							switch (tpage.Depth())
-							{
-								case BitDepth_4Bit:
-									tpu *= 4;
-									break;
-								case BitDepth_8Bit:
-									tpu *= 2;
-									break;
-								case BitDepth_15Bit:
-									break;
-							}
-
-							const auto tpv = static_cast<uint16_t>(256 * tpage.Y());
-
-							Vertex vertex0 = { { v0.x, v0.y, v0.z }, { 0, 0, 0, static_cast<uint16_t>(tpu + uv0.U()), static_cast<uint16_t>(tpv + uv0.V()), std::bit_cast<uint16_t>(clut), rgb.R(), rgb.G(), rgb.B(), 0 } };
-							Vertex vertex1 = { { v1.x, v1.y, v1.z }, { 0, 0, 0, static_cast<uint16_t>(tpu + uv1.U()), static_cast<uint16_t>(tpv + uv1.V()), std::bit_cast<uint16_t>(clut), rgb.R(), rgb.G(), rgb.B(), 0 } };
-							Vertex vertex2 = { { v2.x, v2.y, v2.z }, { 0, 0, 0, static_cast<uint16_t>(tpu + uv2.U()), static_cast<uint16_t>(tpv + uv2.V()), std::bit_cast<uint16_t>(clut), rgb.R(), rgb.G(), rgb.B(), 0 } };
-
-							vertex_indices.push_back(i2);
-							indices.push_back(add_vertex(vertex2));
-
-							vertex_indices.push_back(i1);
-							indices.push_back(add_vertex(vertex1));
-
-							vertex_indices.push_back(i0);
-							indices.push_back(add_vertex(vertex0));
-						}
-					}
-					else
-					{
-
-					}
-				}
-			}
-		}
-
-		primitive_p += 1 + primitive_header.InWords();
-	}
-
-	glBindVertexArray(vao_id.Get());
-
-	glBindBuffer(GL_ARRAY_BUFFER, vbo_id.Get());
-	glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(vertices.size() * sizeof(Vertex)), vertices.data(), GL_STATIC_DRAW);
-
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_id.Get());
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(indices.size() * sizeof(uint16_t)), indices.data(), GL_STATIC_DRAW);
-
-	glEnableVertexAttribArray(0);
-	glVertexAttribIPointer(0, 3, GL_SHORT, sizeof(Vertex), reinterpret_cast<void *>(offsetof(Vertex, position)));
-
-	glEnableVertexAttribArray(1);
-	glVertexAttribIPointer(1, 3, GL_SHORT, sizeof(Vertex), reinterpret_cast<void *>(offsetof(Vertex, attribute.nx)));
-
-	glEnableVertexAttribArray(2);
-	glVertexAttribIPointer(2, 2, GL_UNSIGNED_SHORT, sizeof(Vertex), reinterpret_cast<void *>(offsetof(Vertex, attribute.u)));
-
-	glEnableVertexAttribArray(3);
-	glVertexAttribIPointer(3, 1, GL_UNSIGNED_SHORT, sizeof(Vertex), reinterpret_cast<void *>(offsetof(Vertex, attribute.clut)));
-
-	glEnableVertexAttribArray(4);
-	glVertexAttribIPointer(4, 4, GL_UNSIGNED_BYTE, sizeof(Vertex), reinterpret_cast<void *>(offsetof(Vertex, attribute.r)));
-
-	vertex_count = indices.size();
-}
-
-void Model::Object::Draw() const
-{
-	glBindVertexArray(vao_id.Get());
-	glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(vertex_count), GL_UNSIGNED_SHORT, nullptr);
-}
-
-// TMD model
-Model::Model(const std::shared_ptr<Data> &_tmd_data) : tmd_data(_tmd_data)
-{
-	objects = std::make_unique<Object[]>(tmd_data->objects_size);
-
-	for (uint32_t i = 0; i < tmd_data->objects_size; i++)
-		objects[i].InitMesh(tmd_data->objects[i]);
-}
-
-void Model::Draw() const
-{
-	for (uint32_t i = 0; i < tmd_data->objects_size; i++)
-		objects[i].Draw();
-}
-
 }
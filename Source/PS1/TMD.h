@@ -6,10 +6,7 @@
 
 #include <memory>
 
-#include "Backend/Render.h"
-
 #include "Types/File.h"
-#include "Types/UniqueGLInstance.h"
 
 namespace PaperPup::TMD
 {
@@ -247,59 +244,4 @@ struct Data
 	Data(const Types::File &tmd_file);
 };
 
-// TMD model
-class Model
-{
-private:
-	std::shared_ptr<Data> tmd_data;
-
-	// TMD model object
-	class Object
-	{
-		struct Position
-		{
-			int16_t x, y, z;
-
-			bool operator==(const Position &other) const = default;
-		};
-		struct Attribute
-		{
-			int16_t nx, ny, nz;
-			uint16_t u, v;
-			uint16_t clut;
-			uint8_t r, g, b, x;
-
-			bool operator==(const Attribute &other) const = default;
-		};
-		struct Vertex
-		{
-			Position position;
-			Attribute attribute;
-
-			bool operator==(const Vertex &other) const = default;
-		};
-
-		Types::UniqueGLInstance<GLuint, decltype(glDeleteVertexArrays), &glDeleteVertexArrays, false> vao_id;
-		Types::UniqueGLInstance<GLuint, decltype(glDeleteBuffers), &glDeleteBuffers, false> vbo_id;
-		Types::UniqueGLInstance<GLuint, decltype(glDeleteBuffers), &glDeleteBuffers, false> ebo_id;
-
-		std::vector<uint16_t> vertex_indices;
-		size_t vertex_count = 0;
-
-	public:
-		Object();
-
-		void InitMesh(const Data::Object &object);
-
-		void Draw() const;
-	};
-
-	std::unique_ptr<Object[]> objects;
-
-public:
-	Model(const std::shared_ptr<Data> &_tmd_data);
-
-	void Draw() const;
-};
-
 }
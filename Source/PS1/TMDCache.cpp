@@ -0,0 +1,115 @@
+#include "PS1/TMDCache.h"
+
+#include "Types/MmapFile.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <system_error>
+#include <thread>
+
+namespace PaperPup::TMD
+{
+
+MeshCache::MeshCache(const std::filesystem::path &_directory) : directory(_directory)
+{
+	std::error_code error;
+	std::filesystem::create_directories(directory, error);
+}
+
+std::filesystem::path MeshCache::GetPath(uint64_t source_hash) const
+{
+	char name[32];
+	std::snprintf(name, sizeof(name), "%016llX.tmc", static_cast<unsigned long long>(source_hash));
+	return directory / name;
+}
+
+uint64_t MeshCache::Hash(Types::Span<const char> data)
+{
+	// Multiply-xorshift over 8 bytes at a time, seeded with the size so zero padding still changes the hash
+	uint64_t hash = 0xCBF29CE484222325ULL ^ data.Size();
+
+	size_t i = 0;
+	for (; i + 8 <= data.Size(); i += 8)
+	{
+		uint64_t chunk;
+		std::memcpy(&chunk, data.Data() + i, 8);
+		hash = (hash ^ chunk) * 0x9E3779B97F4A7C15ULL;
+		hash ^= hash >> 29;
+	}
+
+	uint64_t tail = 0;
+	if (i < data.Size())
+		std::memcpy(&tail, data.Data() + i, data.Size() - i);
+	hash = (hash ^ tail) * 0x9E3779B97F4A7C15ULL;
+	return hash ^ (hash >> 32);
+}
+
+std::shared_ptr<const Baked> MeshCache::Load(uint64_t source_hash, uint32_t source_size)
+{
+	std::shared_ptr<const Baked> baked;
+	try
+	{
+		auto path = GetPath(source_hash);
+		if (std::filesystem::exists(path))
+		{
+			baked = std::make_shared<const Baked>(std::make_unique<Types::MmapFile>(path));
+			if (baked->header.source_hash != source_hash || baked->header.source_size != source_size)
+				baked = nullptr;
+		}
+	}
+	catch (std::exception&)
+	{
+		// Corrupt or outdated entries get rebuilt and overwritten
+		baked = nullptr;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	if (baked != nullptr)
+		stats.hits++;
+	else
+		stats.misses++;
+	return baked;
+}
+
+void MeshCache::Store(const Baked &baked)
+{
+	// Write next to the entry and move it in place, so a half written file is never picked up
+	auto path = GetPath(baked.header.source_hash);
+	auto temp_path = path;
+	temp_path += "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+
+	auto span = baked.file->GetSpan();
+	{
+		std::ofstream stream(temp_path, std::ios::binary | std::ios::trunc);
+		if (!stream)
+			return;
+		stream.write(span.Data(), static_cast<std::streamsize>(span.Size()));
+		if (!stream)
+		{
+			stream.close();
+			std::error_code error;
+			std::filesystem::remove(temp_path, error);
+			return;
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename(temp_path, path, error);
+	if (error)
+	{
+		std::filesystem::remove(temp_path, error);
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	stats.stores++;
+}
+
+MeshCache::Stats MeshCache::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return stats;
+}
+
+}
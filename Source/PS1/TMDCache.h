@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+
+#include "Types/Span.h"
+
+#include "PS1/TMDMesh.h"
+
+namespace PaperPup::TMD
+{
+
+// On-disk cache of baked meshes, one file per TMD named after the hash of its bytes
+// Entries are memory mapped, and are ignored if they're from another builder version or don't match their TMD
+// Files are in native byte order, since they're only ever read back on the machine that wrote them
+class MeshCache
+{
+public:
+	struct Stats
+	{
+		uint64_t hits;
+		uint64_t misses;
+		uint64_t stores;
+	};
+
+private:
+	std::filesystem::path directory;
+
+	mutable std::mutex mutex;
+	Stats stats = {};
+
+	std::filesystem::path GetPath(uint64_t source_hash) const;
+
+public:
+	MeshCache(const std::filesystem::path &_directory);
+
+	static uint64_t Hash(Types::Span<const char> data);
+
+	// Gets the baked meshes of a TMD, or nullptr if there's no valid entry for it
+	std::shared_ptr<const Baked> Load(uint64_t source_hash, uint32_t source_size);
+
+	// Writes baked meshes for the TMD they're tagged with
+	// Failing to write is ignored, the meshes just get built again next time
+	void Store(const Baked &baked);
+
+	Stats GetStats() const;
+};
+
+}
@@ -0,0 +1,883 @@
+#include "PS1/TMDMesh.h"
+
+#include "Backend/Jobs.h"
+
+#include "PS1/TMDCache.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <type_traits>
+#include <utility>
+
+namespace PaperPup::TMD
+{
+
+// Deduplicates vertices with an open addressing hash table over their bytes
+// Indices are handed out in first-seen order, so the output matches a linear search
+template <typename T>
+class Welder
+{
+	static_assert(std::has_unique_object_representations_v<T>, "T may not have padding bits");
+
+private:
+	std::vector<T> &vertices;
+
+	// Vertex index + 1, or 0 if empty
+	std::vector<uint32_t> table;
+	size_t mask = 0;
+
+	static uint64_t Hash(const T &vertex)
+	{
+		const char *data = reinterpret_cast<const char *>(&vertex);
+
+		uint64_t hash = 0xCBF29CE484222325ULL;
+		size_t i = 0;
+		for (; i + 8 <= sizeof(T); i += 8)
+		{
+			uint64_t word;
+			std::memcpy(&word, data + i, 8);
+			hash = (hash ^ word) * 0x9E3779B97F4A7C15ULL;
+			hash ^= hash >> 32;
+		}
+		if (i < sizeof(T))
+		{
+			uint64_t word = 0;
+			std::memcpy(&word, data + i, sizeof(T) - i);
+			hash = (hash ^ word) * 0x9E3779B97F4A7C15ULL;
+			hash ^= hash >> 32;
+		}
+		return hash;
+	}
+
+	void Rehash(size_t capacity)
+	{
+		table.assign(capacity, 0);
+		mask = capacity - 1;
+
+		for (size_t i = 0; i < vertices.size(); i++)
+		{
+			size_t slot = Hash(vertices[i]) & mask;
+			while (table[slot] != 0)
+				slot = (slot + 1) & mask;
+			table[slot] = static_cast<uint32_t>(i + 1);
+		}
+	}
+
+public:
+	Welder(std::vector<T> &_vertices, size_t expected) : vertices(_vertices)
+	{
+		// Keep the table at most half full
+		Rehash(std::bit_ceil(std::max<size_t>(expected * 2, 16)));
+	}
+
+	uint32_t Add(const T &vertex)
+	{
+		size_t slot = Hash(vertex) & mask;
+		while (table[slot] != 0)
+		{
+			uint32_t i = table[slot] - 1;
+			if (std::memcmp(&vertices[i], &vertex, sizeof(T)) == 0)
+				return i;
+			slot = (slot + 1) & mask;
+		}
+
+		uint32_t i = static_cast<uint32_t>(vertices.size());
+		vertices.push_back(vertex);
+		table[slot] = i + 1;
+
+		if (vertices.size() * 2 > table.size())
+			Rehash(table.size() * 2);
+		return i;
+	}
+};
+
+// Primitive decoding
+// Every primitive layout of the TMD format gets its own handler, and primitives are dispatched
+// through a table indexed by their mode and flags bytes
+struct PrimitiveBuilder
+{
+	const Data::Object &object;
+
+	// The object vertex is part of what's welded, so vertices that move apart when morphed are kept apart
+	struct SourcedVertex
+	{
+		MeshVertex vertex;
+		uint16_t source;
+	};
+	static_assert(sizeof(SourcedVertex) == 18);
+
+	std::vector<SourcedVertex> vertices;
+	Welder<SourcedVertex> welder;
+	Weld weld;
+
+	std::vector<uint16_t> triangle_indices;
+	std::vector<uint16_t> line_indices;
+
+	size_t unsupported = 0;
+
+	// Every primitive has at most 4 corners
+	PrimitiveBuilder(const Data::Object &_object, Weld _weld) : object(_object), welder(vertices, _weld == Weld_Hashed ? _object.primitive_size * 4 : 0), weld(_weld) {}
+
+	const Vector &Position(uint16_t i) const
+	{
+		if (i >= object.vertex_size)
+			throw Types::RuntimeException("TMD primitive vertex out of range");
+		return object.vertex_p[i];
+	}
+
+	uint16_t Add(const Vector &position, uint16_t source, uint16_t u, uint16_t v, uint16_t clut, uint32_t rgb, uint8_t flags)
+	{
+		SourcedVertex vertex = { { { position.x, position.y, position.z }, { u, v, clut, static_cast<uint8_t>(rgb >> 0), static_cast<uint8_t>(rgb >> 8), static_cast<uint8_t>(rgb >> 16), flags } }, source };
+		if (weld == Weld_Hashed)
+			return static_cast<uint16_t>(welder.Add(vertex));
+
+		for (size_t i = 0; i < vertices.size(); i++)
+		{
+			if (std::memcmp(&vertices[i], &vertex, sizeof(SourcedVertex)) == 0)
+				return static_cast<uint16_t>(i);
+		}
+		vertices.push_back(vertex);
+		return static_cast<uint16_t>(vertices.size() - 1);
+	}
+
+	void Triangle(const uint16_t *indices, size_t a, size_t b, size_t c)
+	{
+		triangle_indices.insert(triangle_indices.end(), { indices[a], indices[b], indices[c] });
+	}
+
+	void Line(const uint16_t *indices)
+	{
+		line_indices.insert(line_indices.end(), { indices[0], indices[1] });
+	}
+};
+
+// Colour textured primitives are modulated with when they have none
+static constexpr uint32_t RGB_NEUTRAL = 0x808080;
+
+// Gets halfword `i` of a run of words, less significant half first
+static uint16_t Halfword(const uint32_t *words, size_t i)
+{
+	return static_cast<uint16_t>(words[i >> 1] >> ((i & 1) * 16));
+}
+
+struct TextureBase
+{
+	uint16_t u, v;
+	uint16_t clut;
+	uint8_t flags;
+
+	TextureBase(uint16_t cba, uint16_t tsb)
+	{
+		const auto tpage = std::bit_cast<TexturePage>(tsb);
+
+		// Texture coordinates are in texels, which are smaller than VRAM pixels at lower depths
+		u = static_cast<uint16_t>(64 * tpage.X());
+		switch (tpage.Depth())
+		{
+			case BitDepth_4Bit:
+				u *= 4;
+				break;
+			case BitDepth_8Bit:
+				u *= 2;
+				break;
+			default:
+				break;
+		}
+
+		v = static_cast<uint16_t>(256 * tpage.Y());
+		clut = cba;
+		flags = static_cast<uint8_t>(MeshVertex::Flag_Textured | ((tpage.Depth() & 3) << MeshVertex::Flag_Depth_Shift));
+	}
+};
+
+// Polygons
+// Data comes in the order of texture coordinates, colours, then vertex (and normal) indices
+template <bool Lit, bool Quad, bool Textured, bool Gouraud, bool Gradation>
+struct PolyLayout
+{
+	static constexpr size_t VERTICES = Quad ? 4 : 3;
+
+	static constexpr size_t UV_WORDS = Textured ? VERTICES : 0;
+	static constexpr size_t COLOR_WORDS = Textured ? (Lit ? 0 : (Gouraud ? VERTICES : 1)) : ((Gradation || (!Lit && Gouraud)) ? VERTICES : 1);
+
+	// Lit gouraud pairs every vertex with a normal, lit flat has one normal with the first vertex,
+	// and unlit packs vertices two to a word
+	static constexpr size_t INDEX_WORDS = Lit ? (Gouraud ? VERTICES : 1 + VERTICES / 2) : (VERTICES + 1) / 2;
+
+	static constexpr size_t IN_WORDS = UV_WORDS + COLOR_WORDS + INDEX_WORDS;
+};
+
+template <bool Lit, bool Quad, bool Textured, bool Gouraud, bool Gradation, bool DoubleSided>
+static void DecodePoly(PrimitiveBuilder &builder, const uint32_t *words)
+{
+	using Layout = PolyLayout<Lit, Quad, Textured, Gouraud, Gradation>;
+	constexpr size_t VERTICES = Layout::VERTICES;
+
+	const uint32_t *uv_p = words;
+	const uint32_t *color_p = uv_p + Layout::UV_WORDS;
+	const uint32_t *index_p = color_p + Layout::COLOR_WORDS;
+
+	// Read vertex indices
+	uint16_t sources[VERTICES];
+	for (size_t i = 0; i < VERTICES; i++)
+	{
+		if constexpr (Lit && Gouraud)
+			sources[i] = Halfword(index_p, i * 2 + 1);
+		else if constexpr (Lit)
+			sources[i] = i == 0 ? Halfword(index_p, 1) : Halfword(index_p + 1, i - 1);
+		else
+			sources[i] = Halfword(index_p, i);
+	}
+
+	// Build vertices
+	uint16_t indices[VERTICES];
+	for (size_t i = 0; i < VERTICES; i++)
+	{
+		uint32_t rgb = RGB_NEUTRAL;
+		if constexpr (Layout::COLOR_WORDS == VERTICES)
+			rgb = color_p[i] & 0xFFFFFF;
+		else if constexpr (Layout::COLOR_WORDS == 1)
+			rgb = color_p[0] & 0xFFFFFF;
+
+		if constexpr (Textured)
+		{
+			const TextureBase texture(Halfword(uv_p, 1), Halfword(uv_p, 3));
+			const auto uv = std::bit_cast<PrimitiveUV>(uv_p[i]);
+			indices[i] = builder.Add(builder.Position(sources[i]), sources[i], static_cast<uint16_t>(texture.u + uv.U()), static_cast<uint16_t>(texture.v + uv.V()), texture.clut, rgb, texture.flags);
+		}
+		else
+		{
+			indices[i] = builder.Add(builder.Position(sources[i]), sources[i], 0, 0, 0, rgb, 0);
+		}
+	}
+
+	// Quads are drawn as the triangles 0-1-2 and 1-2-3, wound clockwise
+	builder.Triangle(indices, 2, 1, 0);
+	if constexpr (Quad)
+		builder.Triangle(indices, 1, 2, 3);
+
+	if constexpr (DoubleSided)
+	{
+		builder.Triangle(indices, 0, 1, 2);
+		if constexpr (Quad)
+			builder.Triangle(indices, 3, 2, 1);
+	}
+}
+
+// Lines
+template <bool Gradation>
+struct LineLayout
+{
+	static constexpr size_t COLOR_WORDS = Gradation ? 2 : 1;
+	static constexpr size_t IN_WORDS = COLOR_WORDS + 1;
+};
+
+template <bool Gradation>
+static void DecodeLine(PrimitiveBuilder &builder, const uint32_t *words)
+{
+	using Layout = LineLayout<Gradation>;
+
+	const uint32_t *index_p = words + Layout::COLOR_WORDS;
+	const uint16_t sources[2] = { Halfword(index_p, 0), Halfword(index_p, 1) };
+
+	uint16_t indices[2];
+	for (size_t i = 0; i < 2; i++)
+		indices[i] = builder.Add(builder.Position(sources[i]), sources[i], 0, 0, 0, words[Gradation ? i : 0] & 0xFFFFFF, 0);
+
+	builder.Line(indices);
+}
+
+// 3D sprites
+// Placed as a quad on the XY plane from the vertex, since billboarding isn't done yet
+template <uint8_t Size>
+struct SpriteLayout
+{
+	static constexpr size_t IN_WORDS = Size == PrimitiveHeader::Mode_Size_Any ? 3 : 2;
+};
+
+template <uint8_t Size>
+static void DecodeSprite(PrimitiveBuilder &builder, const uint32_t *words)
+{
+	const uint16_t source = Halfword(words, 0);
+	const Vector &position = builder.Position(source);
+
+	const TextureBase texture(Halfword(words, 3), Halfword(words, 1));
+	const auto uv = std::bit_cast<PrimitiveUV>(words[1]);
+
+	uint16_t w, h;
+	if constexpr (Size == PrimitiveHeader::Mode_Size_Any)
+	{
+		w = Halfword(words, 4);
+		h = Halfword(words, 5);
+	}
+	else
+	{
+		w = h = Size == PrimitiveHeader::Mode_Size_1x1 ? 1 : (Size == PrimitiveHeader::Mode_Size_8x8 ? 8 : 16);
+	}
+
+	uint16_t indices[4];
+	for (size_t i = 0; i < 4; i++)
+	{
+		const uint16_t dx = (i & 1) ? w : 0;
+		const uint16_t dy = (i & 2) ? h : 0;
+
+		const Vector corner = { static_cast<int16_t>(position.x + dx), static_cast<int16_t>(position.y + dy), position.z, 0 };
+		indices[i] = builder.Add(corner, source, static_cast<uint16_t>(texture.u + uv.U() + dx), static_cast<uint16_t>(texture.v + uv.V() + dy), texture.clut, RGB_NEUTRAL, texture.flags);
+	}
+
+	// Sprites face both ways
+	builder.Triangle(indices, 2, 1, 0);
+	builder.Triangle(indices, 1, 2, 3);
+	builder.Triangle(indices, 0, 1, 2);
+	builder.Triangle(indices, 3, 2, 1);
+}
+
+// Decoder table
+// Indexed by `Mode() << 3 | (Flags() & 7)`, every entry is resolved at compile time
+typedef void (*PrimitiveHandler)(PrimitiveBuilder &builder, const uint32_t *words);
+
+struct PrimitiveDecoder
+{
+	PrimitiveHandler handler;
+	size_t in_words;
+};
+
+template <size_t Key>
+static constexpr PrimitiveDecoder SelectDecoder()
+{
+	constexpr uint8_t mode = static_cast<uint8_t>(Key >> 3);
+	constexpr uint8_t flags = static_cast<uint8_t>(Key & 7);
+
+	if constexpr ((mode & PrimitiveHeader::Mode_Kind_Mask) == PrimitiveHeader::Mode_Kind_Poly)
+	{
+		constexpr bool lit = (flags & PrimitiveHeader::Flag_NoLight) == 0;
+		constexpr bool quad = (mode & PrimitiveHeader::Mode_Quad) != 0;
+		constexpr bool textured = (mode & PrimitiveHeader::Mode_Textured) != 0;
+		constexpr bool gouraud = (mode & PrimitiveHeader::Mode_Gouraud) != 0;
+		constexpr bool gradation = (flags & PrimitiveHeader::Flag_Gouraud) != 0;
+		constexpr bool double_sided = (flags & PrimitiveHeader::Flag_DoubleSided) != 0;
+
+		return { &DecodePoly<lit, quad, textured, gouraud, gradation, double_sided>, PolyLayout<lit, quad, textured, gouraud, gradation>::IN_WORDS };
+	}
+	else if constexpr ((mode & PrimitiveHeader::Mode_Kind_Mask) == PrimitiveHeader::Mode_Kind_Line)
+	{
+		constexpr bool gradation = (mode & PrimitiveHeader::Mode_Gouraud) != 0;
+
+		return { &DecodeLine<gradation>, LineLayout<gradation>::IN_WORDS };
+	}
+	else if constexpr ((mode & PrimitiveHeader::Mode_Kind_Mask) == PrimitiveHeader::Mode_Kind_Sprite)
+	{
+		constexpr uint8_t size = mode & PrimitiveHeader::Mode_Size_Mask;
+
+		return { &DecodeSprite<size>, SpriteLayout<size>::IN_WORDS };
+	}
+	else
+	{
+		return { nullptr, 0 };
+	}
+}
+
+template <size_t... Keys>
+static constexpr std::array<PrimitiveDecoder, sizeof...(Keys)> MakeDecoders(std::index_sequence<Keys...>)
+{
+	return { SelectDecoder<Keys>()... };
+}
+
+static constexpr auto PRIMITIVE_DECODERS = MakeDecoders(std::make_index_sequence<0x100 << 3>());
+
+MeshData BuildMesh(const Data::Object &object, bool optimize, Weld weld)
+{
+	PrimitiveBuilder builder(object, weld);
+
+	const auto *primitive_p = object.primitive_p;
+	for (size_t p = 0; p < object.primitive_size; p++)
+	{
+		const auto &primitive_header = *reinterpret_cast<const PrimitiveHeader *>(primitive_p);
+
+		// Primitives whose size doesn't match their layout are skipped
+		const auto &decoder = PRIMITIVE_DECODERS[(primitive_header.Mode() << 3) | (primitive_header.Flags() & 7)];
+		if (decoder.handler != nullptr && decoder.in_words == primitive_header.InWords())
+			decoder.handler(builder, primitive_p + 1);
+		else
+			builder.unsupported++;
+
+		primitive_p += 1 + primitive_header.InWords();
+	}
+
+	// Lines are drawn after triangles from the same buffer
+	MeshData mesh;
+	mesh.unsupported = builder.unsupported;
+	if (!builder.triangle_indices.empty())
+		mesh.draws.push_back({ MeshData::Primitive_Triangles, 0, static_cast<uint32_t>(builder.triangle_indices.size()) });
+	if (!builder.line_indices.empty())
+		mesh.draws.push_back({ MeshData::Primitive_Lines, static_cast<uint32_t>(builder.triangle_indices.size()), static_cast<uint32_t>(builder.line_indices.size()) });
+
+	mesh.vertices.reserve(builder.vertices.size());
+	mesh.vertex_sources.reserve(builder.vertices.size());
+	for (auto &vertex : builder.vertices)
+	{
+		mesh.vertices.push_back(vertex.vertex);
+		mesh.vertex_sources.push_back(vertex.source);
+	}
+
+	mesh.indices = std::move(builder.triangle_indices);
+	mesh.indices.insert(mesh.indices.end(), builder.line_indices.begin(), builder.line_indices.end());
+
+	if (optimize)
+		OptimizeMesh(mesh);
+
+	return mesh;
+}
+
+void ReportUnsupported(const std::vector<MeshData> &meshes)
+{
+	size_t unsupported = 0;
+	for (auto &mesh : meshes)
+		unsupported += mesh.unsupported;
+
+	if (unsupported != 0)
+		std::cout << "TMD has " << unsupported << " unsupported primitives" << std::endl;
+}
+
+// Mesh optimization
+// Vertex scores from Tom Forsyth's "Linear-Speed Vertex Cache Optimisation"
+static constexpr size_t VALENCE_SCORES = 32;
+
+struct VertexScores
+{
+	float cache[VERTEX_CACHE_SIZE];
+	float valence[VALENCE_SCORES];
+
+	VertexScores()
+	{
+		// The last triangle's vertices are scored a bit lower, so the next triangle doesn't just fan around one of them
+		for (size_t i = 0; i < VERTEX_CACHE_SIZE; i++)
+			cache[i] = i < 3 ? 0.75f : std::pow(1.0f - static_cast<float>(i - 3) / static_cast<float>(VERTEX_CACHE_SIZE - 3), 1.5f);
+
+		// Vertices with few triangles left are boosted, so they get finished off instead of left behind
+		valence[0] = -1.0f;
+		for (size_t i = 1; i < VALENCE_SCORES; i++)
+			valence[i] = 2.0f / std::sqrt(static_cast<float>(i));
+	}
+
+	float Score(int32_t position, uint32_t remaining) const
+	{
+		if (remaining == 0)
+			return -1.0f;
+
+		float score = position >= 0 ? cache[position] : 0.0f;
+		return score + (remaining < VALENCE_SCORES ? valence[remaining] : 2.0f / std::sqrt(static_cast<float>(remaining)));
+	}
+};
+
+static const VertexScores VERTEX_SCORES;
+
+// Reorders `triangles` triangles of `indices`
+static void OrderTriangles(uint16_t *indices, size_t triangles, size_t vertices)
+{
+	if (triangles < 2)
+		return;
+
+	// Triangles using each vertex, with the ones not yet emitted at the front of each list
+	std::vector<uint32_t> adjacency_offset(vertices + 1, 0);
+	std::vector<uint32_t> remaining(vertices, 0);
+	for (size_t i = 0; i < triangles * 3; i++)
+		remaining[indices[i]]++;
+	for (size_t i = 0; i < vertices; i++)
+		adjacency_offset[i + 1] = adjacency_offset[i] + remaining[i];
+
+	std::vector<uint32_t> adjacency(triangles * 3);
+	{
+		std::vector<uint32_t> fill(adjacency_offset.begin(), adjacency_offset.end() - 1);
+		for (size_t i = 0; i < triangles * 3; i++)
+			adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+	}
+
+	std::vector<int32_t> position(vertices, -1);
+	std::vector<float> vertex_score(vertices);
+	for (size_t i = 0; i < vertices; i++)
+		vertex_score[i] = VERTEX_SCORES.Score(-1, remaining[i]);
+
+	std::vector<float> triangle_score(triangles);
+	std::vector<bool> emitted(triangles, false);
+	for (size_t i = 0; i < triangles; i++)
+		triangle_score[i] = vertex_score[indices[i * 3 + 0]] + vertex_score[indices[i * 3 + 1]] + vertex_score[indices[i * 3 + 2]];
+
+	size_t best = static_cast<size_t>(std::max_element(triangle_score.begin(), triangle_score.end()) - triangle_score.begin());
+
+	// The cache has room for the 3 vertices pushed in before the ones pushed out are dropped
+	std::vector<uint16_t> cache, next_cache;
+	cache.reserve(VERTEX_CACHE_SIZE + 3);
+	next_cache.reserve(VERTEX_CACHE_SIZE + 3);
+
+	std::vector<uint32_t> order;
+	order.reserve(triangles);
+
+	size_t scan = 0;
+	while (1)
+	{
+		// Emit the best triangle and take it off its vertices
+		order.push_back(static_cast<uint32_t>(best));
+		emitted[best] = true;
+
+		const uint16_t *corners = indices + best * 3;
+		for (size_t i = 0; i < 3; i++)
+		{
+			uint16_t v = corners[i];
+			uint32_t *list = adjacency.data() + adjacency_offset[v];
+			uint32_t *found = std::find(list, list + remaining[v], static_cast<uint32_t>(best));
+			std::swap(*found, list[remaining[v] - 1]);
+			remaining[v]--;
+		}
+
+		// Push its vertices to the front of the cache
+		next_cache.assign(corners, corners + 3);
+		for (uint16_t v : cache)
+		{
+			if (v != corners[0] && v != corners[1] && v != corners[2])
+				next_cache.push_back(v);
+		}
+		std::swap(cache, next_cache);
+
+		// Rescore everything in the cache, and whatever just fell out of it
+		for (size_t i = 0; i < cache.size(); i++)
+		{
+			uint16_t v = cache[i];
+			position[v] = i < VERTEX_CACHE_SIZE ? static_cast<int32_t>(i) : -1;
+			vertex_score[v] = VERTEX_SCORES.Score(position[v], remaining[v]);
+		}
+
+		// The next triangle is the best one touching the cache
+		float best_score = -1.0f;
+		for (uint16_t v : cache)
+		{
+			const uint32_t *list = adjacency.data() + adjacency_offset[v];
+			for (uint32_t j = 0; j < remaining[v]; j++)
+			{
+				uint32_t t = list[j];
+				const uint16_t *tri = indices + t * 3;
+				triangle_score[t] = vertex_score[tri[0]] + vertex_score[tri[1]] + vertex_score[tri[2]];
+				if (triangle_score[t] > best_score)
+				{
+					best_score = triangle_score[t];
+					best = t;
+				}
+			}
+		}
+
+		if (cache.size() > VERTEX_CACHE_SIZE)
+			cache.resize(VERTEX_CACHE_SIZE);
+
+		// Nothing touches the cache, so start again from the next triangle left
+		if (best_score < 0.0f)
+		{
+			while (scan < triangles && emitted[scan])
+				scan++;
+			if (scan == triangles)
+				break;
+			best = scan;
+		}
+	}
+
+	// Apply the order
+	std::vector<uint16_t> old_indices(indices, indices + triangles * 3);
+	for (size_t i = 0; i < triangles; i++)
+		std::copy_n(old_indices.data() + order[i] * 3, 3, indices + i * 3);
+}
+
+void OptimizeMesh(MeshData &mesh)
+{
+	for (auto &draw : mesh.draws)
+	{
+		if (draw.primitive == MeshData::Primitive_Triangles)
+			OrderTriangles(mesh.indices.data() + draw.first, draw.count / 3, mesh.vertices.size());
+	}
+
+	// Renumber vertices in first use order, the welder never leaves any unused
+	static constexpr uint16_t UNUSED = 0xFFFF;
+	std::vector<uint16_t> remap(mesh.vertices.size(), UNUSED);
+	std::vector<MeshVertex> vertices;
+	std::vector<uint16_t> vertex_sources;
+	vertices.reserve(mesh.vertices.size());
+	vertex_sources.reserve(mesh.vertices.size());
+
+	for (auto &index : mesh.indices)
+	{
+		if (remap[index] == UNUSED)
+		{
+			remap[index] = static_cast<uint16_t>(vertices.size());
+			vertices.push_back(mesh.vertices[index]);
+			vertex_sources.push_back(mesh.vertex_sources[index]);
+		}
+		index = remap[index];
+	}
+
+	mesh.vertices = std::move(vertices);
+	mesh.vertex_sources = std::move(vertex_sources);
+}
+
+CacheStats SimulateVertexCache(const MeshData &mesh)
+{
+	CacheStats stats;
+
+	for (auto &draw : mesh.draws)
+	{
+		if (draw.primitive != MeshData::Primitive_Triangles)
+			continue;
+
+		// FIFO, vertices stay put when they hit
+		std::array<int32_t, VERTEX_CACHE_SIZE> cache;
+		cache.fill(-1);
+		size_t head = 0;
+
+		for (size_t i = draw.first; i < draw.first + draw.count; i++)
+		{
+			int32_t v = mesh.indices[i];
+			if (std::find(cache.begin(), cache.end(), v) != cache.end())
+				continue;
+
+			cache[head] = v;
+			head = (head + 1) % VERTEX_CACHE_SIZE;
+			stats.misses++;
+		}
+		stats.triangles += draw.count / 3;
+	}
+
+	return stats;
+}
+
+void ReportACMR(const INT::INT &int_file, const std::vector<std::string> &names, std::ostream &stream)
+{
+	for (auto &name : names)
+	{
+		INT::Member tmd_file = int_file.Open(name);
+		if (!tmd_file)
+			throw Types::RuntimeException("TMD not found in INT");
+
+		Data data(tmd_file);
+
+		CacheStats before, after;
+		for (uint32_t i = 0; i < data.objects_size; i++)
+		{
+			MeshData mesh = BuildMesh(data.objects[i], false);
+
+			CacheStats stats = SimulateVertexCache(mesh);
+			before.triangles += stats.triangles;
+			before.misses += stats.misses;
+
+			OptimizeMesh(mesh);
+
+			stats = SimulateVertexCache(mesh);
+			after.triangles += stats.triangles;
+			after.misses += stats.misses;
+		}
+
+		stream << name << ": " << before.triangles << " triangles, ACMR " << before.ACMR() << " -> " << after.ACMR() << std::endl;
+	}
+}
+
+// Baked meshes
+Baked::Baked(std::unique_ptr<Types::File> _file) : file(std::move(_file))
+{
+	header = file->Get<Header>(0);
+	if (std::memcmp(header.magic, "PPTM", 4))
+		throw Types::RuntimeException("Baked meshes have invalid magic");
+	if (header.version != MESH_BUILDER_VERSION)
+		throw Types::RuntimeException("Baked meshes are from a different builder version");
+
+	size_t objects_p = sizeof(Header);
+	size_t draws_p = objects_p + sizeof(Object) * header.objects_size;
+	size_t vertices_p = draws_p + sizeof(MeshData::Draw) * header.draws_size;
+	size_t indices_p = vertices_p + sizeof(MeshVertex) * header.vertices_size;
+	size_t vertex_sources_p = indices_p + sizeof(uint16_t) * header.indices_size;
+
+	objects = file->GetSubspan<const Object>(objects_p, header.objects_size);
+	draws = file->GetSubspan<const MeshData::Draw>(draws_p, header.draws_size);
+	vertices = file->GetSubspan<const MeshVertex>(vertices_p, header.vertices_size);
+	indices = file->GetSubspan<const uint16_t>(indices_p, header.indices_size);
+	vertex_sources = file->GetSubspan<const uint16_t>(vertex_sources_p, header.vertices_size);
+
+	for (auto &object : objects)
+	{
+		if (object.base_vertex > header.vertices_size || object.vertex_size > header.vertices_size - object.base_vertex)
+			throw Types::RuntimeException("Baked object vertices out of bounds");
+		if (object.first_index > header.indices_size || object.index_size > header.indices_size - object.first_index)
+			throw Types::RuntimeException("Baked object indices out of bounds");
+		if (object.first_draw > header.draws_size || object.draws_size > header.draws_size - object.first_draw)
+			throw Types::RuntimeException("Baked object draws out of bounds");
+
+		for (auto &draw : draws.Slice(object.first_draw, object.draws_size))
+		{
+			if (draw.primitive > MeshData::Primitive_Lines || draw.first > object.index_size || draw.count > object.index_size - draw.first)
+				throw Types::RuntimeException("Baked draw out of bounds");
+		}
+
+		for (auto index : indices.Slice(object.first_index, object.index_size))
+		{
+			if (index >= object.vertex_size)
+				throw Types::RuntimeException("Baked index out of bounds");
+		}
+	}
+}
+
+std::shared_ptr<const Baked> Bake(const std::vector<MeshData> &meshes, uint64_t source_hash, uint32_t source_size)
+{
+	Baked::Header header = {};
+	std::memcpy(header.magic, "PPTM", 4);
+	header.version = MESH_BUILDER_VERSION;
+	header.source_hash = source_hash;
+	header.source_size = source_size;
+	header.objects_size = static_cast<uint32_t>(meshes.size());
+
+	for (auto &mesh : meshes)
+	{
+		header.draws_size += static_cast<uint32_t>(mesh.draws.size());
+		header.vertices_size += static_cast<uint32_t>(mesh.vertices.size());
+		header.indices_size += static_cast<uint32_t>(mesh.indices.size());
+	}
+
+	size_t size = sizeof(Baked::Header) +
+		sizeof(Baked::Object) * header.objects_size +
+		sizeof(MeshData::Draw) * header.draws_size +
+		sizeof(MeshVertex) * header.vertices_size +
+		sizeof(uint16_t) * header.indices_size +
+		sizeof(uint16_t) * header.vertices_size;
+
+	// Lay every section out in order
+	auto data = std::make_unique<char[]>(size);
+	char *objects_p = data.get() + sizeof(Baked::Header);
+	char *draws_p = objects_p + sizeof(Baked::Object) * header.objects_size;
+	char *vertices_p = draws_p + sizeof(MeshData::Draw) * header.draws_size;
+	char *indices_p = vertices_p + sizeof(MeshVertex) * header.vertices_size;
+	char *vertex_sources_p = indices_p + sizeof(uint16_t) * header.indices_size;
+
+	std::memcpy(data.get(), &header, sizeof(header));
+
+	Baked::Object object = {};
+	for (auto &mesh : meshes)
+	{
+		object.vertex_size = static_cast<uint32_t>(mesh.vertices.size());
+		object.index_size = static_cast<uint32_t>(mesh.indices.size());
+		object.draws_size = static_cast<uint32_t>(mesh.draws.size());
+
+		std::memcpy(objects_p, &object, sizeof(object));
+		objects_p += sizeof(object);
+
+		draws_p = reinterpret_cast<char *>(std::copy(mesh.draws.begin(), mesh.draws.end(), reinterpret_cast<MeshData::Draw *>(draws_p)));
+		vertices_p = reinterpret_cast<char *>(std::copy(mesh.vertices.begin(), mesh.vertices.end(), reinterpret_cast<MeshVertex *>(vertices_p)));
+		indices_p = reinterpret_cast<char *>(std::copy(mesh.indices.begin(), mesh.indices.end(), reinterpret_cast<uint16_t *>(indices_p)));
+		vertex_sources_p = reinterpret_cast<char *>(std::copy(mesh.vertex_sources.begin(), mesh.vertex_sources.end(), reinterpret_cast<uint16_t *>(vertex_sources_p)));
+
+		object.base_vertex += object.vertex_size;
+		object.first_index += object.index_size;
+		object.first_draw += object.draws_size;
+	}
+
+	return std::make_shared<const Baked>(std::make_unique<Types::MemoryFile>(std::move(data), size));
+}
+
+std::vector<Prepared> Prepare(const INT::INT &int_file, const std::vector<std::string> &names, MeshCache *cache)
+{
+	auto &jobs = Jobs::Backend::Instance();
+
+	// Parse every TMD and look for its meshes in the cache
+	std::vector<Prepared> prepared(names.size());
+	std::vector<uint64_t> source_hashes(names.size());
+	std::vector<uint32_t> source_sizes(names.size());
+
+	// Members are opened here since their pins can't be touched from the workers
+	std::vector<INT::Member> tmd_files(names.size());
+	for (size_t i = 0; i < names.size(); i++)
+	{
+		tmd_files[i] = int_file.Open(names[i]);
+		if (!tmd_files[i])
+			throw Types::RuntimeException("TMD not found in INT");
+	}
+
+	jobs.ParallelFor(names.size(), [&](size_t i)
+	{
+		const INT::Member &tmd_file = tmd_files[i];
+		prepared[i].data = std::make_shared<Data>(tmd_file);
+
+		auto span = tmd_file.GetSpan();
+		source_hashes[i] = MeshCache::Hash(Types::Span<const char>(span.Data(), span.Size()));
+		source_sizes[i] = static_cast<uint32_t>(span.Size());
+
+		if (cache != nullptr)
+		{
+			auto baked = cache->Load(source_hashes[i], source_sizes[i]);
+			if (baked != nullptr && baked->header.objects_size == prepared[i].data->objects_size)
+				prepared[i].baked = std::move(baked);
+		}
+	});
+
+	// Build every object of every model that wasn't cached, so one big model doesn't hold the rest up
+	std::vector<std::vector<MeshData>> meshes(prepared.size());
+	std::vector<std::pair<size_t, uint32_t>> objects;
+	std::vector<size_t> models;
+	for (size_t i = 0; i < prepared.size(); i++)
+	{
+		if (prepared[i].baked != nullptr)
+			continue;
+
+		meshes[i].resize(prepared[i].data->objects_size);
+		for (uint32_t j = 0; j < prepared[i].data->objects_size; j++)
+			objects.emplace_back(i, j);
+		models.push_back(i);
+	}
+
+	jobs.ParallelFor(objects.size(), [&](size_t i)
+	{
+		auto [model, object] = objects[i];
+		meshes[model][object] = BuildMesh(prepared[model].data->objects[object]);
+	});
+
+	for (size_t model : models)
+		ReportUnsupported(meshes[model]);
+
+	jobs.ParallelFor(models.size(), [&](size_t i)
+	{
+		size_t model = models[i];
+		prepared[model].baked = Bake(meshes[model], source_hashes[model], source_sizes[model]);
+		if (cache != nullptr)
+			cache->Store(*prepared[model].baked);
+	});
+
+	return prepared;
+}
+
+Prepared Prepare(const Types::File &tmd_file, MeshCache *cache)
+{
+	Prepared prepared;
+	prepared.data = std::make_shared<Data>(tmd_file);
+
+	auto span = tmd_file.GetSpan();
+	uint64_t source_hash = MeshCache::Hash(Types::Span<const char>(span.Data(), span.Size()));
+	uint32_t source_size = static_cast<uint32_t>(span.Size());
+
+	if (cache != nullptr)
+	{
+		auto baked = cache->Load(source_hash, source_size);
+		if (baked != nullptr && baked->header.objects_size == prepared.data->objects_size)
+		{
+			prepared.baked = std::move(baked);
+			return prepared;
+		}
+	}
+
+	std::vector<MeshData> meshes(prepared.data->objects_size);
+	for (uint32_t i = 0; i < prepared.data->objects_size; i++)
+		meshes[i] = BuildMesh(prepared.data->objects[i]);
+	ReportUnsupported(meshes);
+
+	prepared.baked = Bake(meshes, source_hash, source_size);
+	if (cache != nullptr)
+		cache->Store(*prepared.baked);
+	return prepared;
+}
+
+}
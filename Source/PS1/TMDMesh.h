@@ -0,0 +1,184 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "Types/File.h"
+#include "Types/Span.h"
+
+#include "PS1/INT.h"
+#include "PS1/TMD.h"
+
+namespace PaperPup::TMD
+{
+
+// Vertex of a built mesh
+struct MeshVertex
+{
+	enum Flags
+	{
+		Flag_Textured = (1 << 0),
+		Flag_Depth_Shift = 1, // 2 bits of BitDepth, for textured vertices
+	};
+
+	struct Position
+	{
+		int16_t x, y, z;
+
+		bool operator==(const Position &other) const = default;
+	};
+	// TMD normals aren't used for lighting, so they aren't kept
+	struct Attribute
+	{
+		uint16_t u, v;
+		uint16_t clut;
+		uint8_t r, g, b, flags;
+
+		bool operator==(const Attribute &other) const = default;
+	};
+
+	Position position;
+	Attribute attribute;
+
+	bool operator==(const MeshVertex &other) const = default;
+};
+static_assert(sizeof(MeshVertex) == 16);
+
+// Mesh built from an object, before it's uploaded
+struct MeshData
+{
+	enum Primitive : uint32_t
+	{
+		Primitive_Triangles,
+		Primitive_Lines,
+	};
+
+	// Range of indices drawn as one kind of primitive
+	struct Draw
+	{
+		Primitive primitive;
+		uint32_t first;
+		uint32_t count;
+	};
+
+	std::vector<MeshVertex> vertices;
+	std::vector<uint16_t> indices;
+	std::vector<uint16_t> vertex_sources; // Object vertex each vertex was built from
+
+	std::vector<Draw> draws;
+
+	// Primitives skipped for being unsupported or the wrong size
+	size_t unsupported = 0;
+};
+
+// Bump whenever BuildMesh output changes, so stale cached meshes get rebuilt
+static constexpr uint32_t MESH_BUILDER_VERSION = 4;
+
+// Post-transform vertex cache size meshes are ordered for, and ACMR is measured with
+static constexpr size_t VERTEX_CACHE_SIZE = 32;
+
+// How BuildMesh finds duplicate vertices
+// Both hand out indices in first-seen order, so they give identical meshes, the linear search is only
+// kept as the reference to check and benchmark the hash table against
+enum Weld
+{
+	Weld_Hashed,
+	Weld_Linear,
+};
+
+// Builds the mesh of an object without touching GL
+// Unless `optimize` is false, the mesh is also passed through OptimizeMesh
+MeshData BuildMesh(const Data::Object &object, bool optimize = true, Weld weld = Weld_Hashed);
+
+// Logs how many primitives a model's meshes skipped, if any
+// Called once the meshes are built, so the workers building them don't write to the log
+void ReportUnsupported(const std::vector<MeshData> &meshes);
+
+// Reorders a mesh's triangles for the post-transform vertex cache (Forsyth's linear-speed method),
+// then renumbers its vertices in the order they're first used, so fetches walk through the buffer
+void OptimizeMesh(MeshData &mesh);
+
+// Vertex cache misses of a mesh's triangles, through a FIFO cache of VERTEX_CACHE_SIZE vertices
+struct CacheStats
+{
+	size_t triangles = 0;
+	size_t misses = 0;
+
+	// Average cache miss ratio, from 3 at worst down towards 0.5 for a regular grid
+	double ACMR() const
+	{
+		return triangles != 0 ? static_cast<double>(misses) / static_cast<double>(triangles) : 0.0;
+	}
+};
+
+CacheStats SimulateVertexCache(const MeshData &mesh);
+
+// Prints every model's ACMR with and without OptimizeMesh, so the optimizer can be checked without a GPU
+void ReportACMR(const INT::INT &int_file, const std::vector<std::string> &names, std::ostream &stream);
+
+// Meshes of every object of a model, packed one after another the way they're uploaded
+// This is also the mesh cache format, so cached meshes are used straight from their file
+struct Baked
+{
+	struct Header
+	{
+		char magic[4]; // = "PPTM"
+		uint32_t version; // MESH_BUILDER_VERSION
+		uint64_t source_hash; // Of the TMD the meshes were built from
+		uint32_t source_size;
+		uint32_t objects_size;
+		uint32_t draws_size;
+		uint32_t vertices_size;
+		uint32_t indices_size;
+		uint32_t pad;
+	};
+	static_assert(sizeof(Header) == 40);
+
+	struct Object
+	{
+		uint32_t base_vertex;
+		uint32_t vertex_size;
+		uint32_t first_index;
+		uint32_t index_size;
+		uint32_t first_draw; // Draws are relative to the object's first index
+		uint32_t draws_size;
+	};
+	static_assert(sizeof(Object) == 24);
+
+	std::unique_ptr<Types::File> file;
+
+	Header header;
+	Types::Span<const Object> objects;
+	Types::Span<const MeshData::Draw> draws;
+	Types::Span<const MeshVertex> vertices;
+	Types::Span<const uint16_t> indices; // Relative to their object's base vertex
+	Types::Span<const uint16_t> vertex_sources; // Parallel to `vertices`
+
+	// Checks that every range and index is in bounds, so nothing read from disk can make GL read out of bounds
+	Baked(std::unique_ptr<Types::File> _file);
+};
+
+// Packs built meshes, tagging them with the TMD they came from
+std::shared_ptr<const Baked> Bake(const std::vector<MeshData> &meshes, uint64_t source_hash, uint32_t source_size);
+
+class MeshCache;
+
+// TMD parsed and with all of its meshes built, ready to be uploaded
+struct Prepared
+{
+	std::shared_ptr<Data> data;
+	std::shared_ptr<const Baked> baked;
+};
+
+// Parses TMDs from an INT and builds their meshes in parallel on the job backend
+// With a cache, meshes are loaded from it when the TMD hasn't changed, and stored to it when built
+// Must be called on the thread that owns the INT, only creating the models needs GL
+std::vector<Prepared> Prepare(const INT::INT &int_file, const std::vector<std::string> &names, MeshCache *cache = nullptr);
+
+// Same as above for a single TMD, building its meshes on the calling thread
+Prepared Prepare(const Types::File &tmd_file, MeshCache *cache = nullptr);
+
+}
@@ -0,0 +1,112 @@
+#include "PS1/TMDModel.h"
+
+namespace PaperPup::TMD
+{
+
+// Draw statistics, only touched from the GL thread
+static Model::DrawStats draw_stats = {};
+
+// TMD model
+Model::Model(const std::shared_ptr<Data> &_tmd_data) : tmd_data(_tmd_data)
+{
+	std::vector<MeshData> meshes;
+	for (uint32_t i = 0; i < tmd_data->objects_size; i++)
+		meshes.emplace_back(BuildMesh(tmd_data->objects[i]));
+	ReportUnsupported(meshes);
+
+	Upload(*Bake(meshes, 0, 0));
+}
+
+Model::Model(const Prepared &prepared) : tmd_data(prepared.data)
+{
+	Upload(*prepared.baked);
+}
+
+Model::Model(const std::shared_ptr<Data> &_tmd_data, const Baked &baked) : tmd_data(_tmd_data)
+{
+	Upload(baked);
+}
+
+void Model::Upload(const Baked &baked)
+{
+	if (baked.header.objects_size != tmd_data->objects_size)
+		throw Types::RuntimeException("Baked meshes don't match the TMD");
+
+	// Baked meshes are already laid out one object after another
+	// Indices stay relative to their object, and are offset by its base vertex when drawing
+	objects = std::make_unique<Object[]>(baked.objects.Size());
+
+	Batch triangles = { GL_TRIANGLES, {}, {}, {} };
+	Batch lines = { GL_LINES, {}, {}, {} };
+
+	for (size_t i = 0; i < baked.objects.Size(); i++)
+	{
+		auto &baked_object = baked.objects[i];
+		auto &object = objects[i];
+
+		object.base_vertex = static_cast<GLint>(baked_object.base_vertex);
+		object.vertex_size = static_cast<GLsizei>(baked_object.vertex_size);
+
+		for (auto &draw : baked.draws.Slice(baked_object.first_draw, baked_object.draws_size))
+		{
+			Batch &batch = draw.primitive == MeshData::Primitive_Lines ? lines : triangles;
+			batch.counts.push_back(static_cast<GLsizei>(draw.count));
+			batch.offsets.push_back(reinterpret_cast<const void *>((baked_object.first_index + draw.first) * sizeof(uint16_t)));
+			batch.base_vertices.push_back(object.base_vertex);
+		}
+	}
+
+	if (!triangles.counts.empty())
+		batches.push_back(std::move(triangles));
+	if (!lines.counts.empty())
+		batches.push_back(std::move(lines));
+
+	// Upload
+	glGenVertexArrays(1, vao_id.GetAddressOf());
+	glGenBuffers(1, vbo_id.GetAddressOf());
+	glGenBuffers(1, ebo_id.GetAddressOf());
+
+	glBindVertexArray(vao_id.Get());
+
+	glBindBuffer(GL_ARRAY_BUFFER, vbo_id.Get());
+	glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(baked.vertices.Size() * sizeof(Vertex)), baked.vertices.Data(), GL_STATIC_DRAW);
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_id.Get());
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(baked.indices.Size() * sizeof(uint16_t)), baked.indices.Data(), GL_STATIC_DRAW);
+
+	glEnableVertexAttribArray(0);
+	glVertexAttribIPointer(0, 3, GL_SHORT, sizeof(Vertex), reinterpret_cast<void *>(offsetof(Vertex, position)));
+
+	glEnableVertexAttribArray(1);
+	glVertexAttribIPointer(1, 2, GL_UNSIGNED_SHORT, sizeof(Vertex), reinterpret_cast<void *>(offsetof(Vertex, attribute.u)));
+
+	glEnableVertexAttribArray(2);
+	glVertexAttribIPointer(2, 1, GL_UNSIGNED_SHORT, sizeof(Vertex), reinterpret_cast<void *>(offsetof(Vertex, attribute.clut)));
+
+	glEnableVertexAttribArray(3);
+	glVertexAttribIPointer(3, 4, GL_UNSIGNED_BYTE, sizeof(Vertex), reinterpret_cast<void *>(offsetof(Vertex, attribute.r)));
+}
+
+void Model::Draw() const
+{
+	glBindVertexArray(vao_id.Get());
+
+	for (auto &batch : batches)
+	{
+		glMultiDrawElementsBaseVertex(batch.mode, batch.counts.data(), GL_UNSIGNED_SHORT, batch.offsets.data(), static_cast<GLsizei>(batch.counts.size()), batch.base_vertices.data());
+		draw_stats.draw_calls++;
+	}
+	draw_stats.objects += tmd_data->objects_size;
+}
+
+Model::DrawStats Model::GetDrawStats()
+{
+	return draw_stats;
+}
+
+void Model::ResetDrawStats()
+{
+	draw_stats = {};
+}
+
+}
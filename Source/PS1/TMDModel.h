@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Backend/Render.h"
+
+#include "Types/UniqueGLInstance.h"
+
+#include "PS1/TMD.h"
+#include "PS1/TMDMesh.h"
+
+namespace PaperPup::TMD
+{
+
+// TMD model
+// Every object is packed into one vertex and index buffer, so a model draws with one VAO bind
+class Model
+{
+public:
+	struct DrawStats
+	{
+		uint64_t draw_calls; // GL draw calls issued
+		uint64_t objects; // Objects drawn by them
+	};
+
+protected:
+	typedef MeshVertex Vertex;
+
+	std::shared_ptr<Data> tmd_data;
+
+	Types::UniqueGLInstance<GLuint, decltype(glDeleteVertexArrays), &glDeleteVertexArrays, false> vao_id;
+	Types::UniqueGLInstance<GLuint, decltype(glDeleteBuffers), &glDeleteBuffers, false> vbo_id;
+	Types::UniqueGLInstance<GLuint, decltype(glDeleteBuffers), &glDeleteBuffers, false> ebo_id;
+
+	// Where an object's mesh lives in the shared buffers
+	struct Object
+	{
+		GLint base_vertex = 0;
+		GLsizei vertex_size = 0;
+	};
+	std::unique_ptr<Object[]> objects;
+
+	// Object draws merged by primitive kind
+	struct Batch
+	{
+		GLenum mode;
+		std::vector<GLsizei> counts;
+		std::vector<const void *> offsets;
+		std::vector<GLint> base_vertices;
+	};
+	std::vector<Batch> batches;
+
+	void Upload(const Baked &baked);
+
+public:
+	Model(const std::shared_ptr<Data> &_tmd_data);
+	Model(const Prepared &prepared);
+	Model(const std::shared_ptr<Data> &_tmd_data, const Baked &baked);
+
+	void Draw() const;
+
+	static DrawStats GetDrawStats();
+	static void ResetDrawStats();
+};
+
+}
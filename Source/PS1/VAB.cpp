@@ -0,0 +1,317 @@
+#include "PS1/VAB.h"
+
+#include "Backend/Jobs.h"
+
+#include "PS1/ADPCM.h"
+
+#include "Util/Endian.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace PaperPup::VAB
+{
+
+Data::Data(const Types::File &vab_file)
+{
+	// Read header
+	header = vab_file.Get<Header>(0);
+	if (std::memcmp(header.form, "pBAV", 4))
+		throw Types::RuntimeException("VAB has invalid magic");
+
+	header.version = Endian::SwapLE(header.version);
+	header.id = Endian::SwapLE(header.id);
+	header.file_size = Endian::SwapLE(header.file_size);
+	header.programs = Endian::SwapLE(header.programs);
+	header.tones = Endian::SwapLE(header.tones);
+	header.vags = Endian::SwapLE(header.vags);
+
+	if (header.programs > PROGRAMS_MAX)
+		throw Types::RuntimeException("VAB has too many programs");
+	if (header.vags >= VAGS_MAX)
+		throw Types::RuntimeException("VAB has too many VAGs");
+
+	// Read programs and their tones
+	size_t programs_p = sizeof(Header);
+	size_t tones_p = programs_p + sizeof(ProgramAttributes) * PROGRAMS_MAX;
+	size_t vags_p = tones_p + sizeof(ToneAttributes) * PROGRAM_TONES * header.programs;
+	size_t body_p = vags_p + sizeof(uint16_t) * VAGS_MAX;
+
+	auto programs_span = vab_file.GetSubspan<ProgramAttributes>(programs_p, PROGRAMS_MAX);
+	programs = std::make_unique<ProgramAttributes[]>(PROGRAMS_MAX);
+	std::transform(programs_span.begin(), programs_span.end(), programs.get(), [](ProgramAttributes p)
+	{
+		p.attr = Endian::SwapLE(p.attr);
+		return p;
+	});
+
+	auto tones_span = vab_file.GetSubspan<ToneAttributes>(tones_p, PROGRAM_TONES * header.programs);
+	tones = std::make_unique<ToneAttributes[]>(tones_span.Size());
+	std::transform(tones_span.begin(), tones_span.end(), tones.get(), [](ToneAttributes t)
+	{
+		t.adsr1 = Endian::SwapLE(t.adsr1);
+		t.adsr2 = Endian::SwapLE(t.adsr2);
+		t.program = Endian::SwapLE(t.program);
+		t.vag = Endian::SwapLE(t.vag);
+		return t;
+	});
+
+	// Read VAG table, sizes are stored divided by 8 and the first entry is unused
+	auto vags_span = vab_file.GetSubspan<uint16_t>(vags_p, VAGS_MAX);
+
+	vags_size = header.vags;
+	vags = std::make_unique<VAG[]>(vags_size);
+
+	uint32_t body_size = 0;
+	for (uint16_t i = 0; i < vags_size; i++)
+	{
+		uint32_t size = static_cast<uint32_t>(Endian::SwapLE(vags_span[i + 1])) << 3;
+		vags[i] = { body_size, size };
+		body_size += size;
+	}
+
+	// Copy body
+	auto body_span = vab_file.GetSubspan<char>(body_p, body_size);
+	adpcm = std::make_unique<char[]>(body_size);
+	std::memcpy(adpcm.get(), body_span.Data(), body_size);
+}
+
+// Waveform decoding
+Layout Layout::Scan(Types::Span<const char> adpcm)
+{
+	Layout layout = {};
+
+	size_t blocks = adpcm.Size() / BLOCK_SIZE;
+	for (size_t i = 0; i < blocks; i++)
+	{
+		unsigned char flags = static_cast<unsigned char>(adpcm[i * BLOCK_SIZE + 1]);
+		if (flags & BlockFlag_LoopStart)
+			layout.loop_start = static_cast<uint32_t>(i * BLOCK_SAMPLES);
+
+		// Nothing past the loop end is ever played
+		if (flags & BlockFlag_LoopEnd)
+		{
+			layout.length = static_cast<uint32_t>((i + 1) * BLOCK_SAMPLES);
+			layout.loop = (flags & BlockFlag_Repeat) != 0;
+			return layout;
+		}
+	}
+
+	layout.length = static_cast<uint32_t>(blocks * BLOCK_SAMPLES);
+	return layout;
+}
+
+void Decode(Types::Span<const char> adpcm, const Layout &layout, int16_t *out)
+{
+	PS1::ADPCMDecode decoder;
+
+	size_t blocks = layout.length / BLOCK_SAMPLES;
+	for (size_t i = 0; i < blocks; i++)
+		decoder.DecodeSPUBlock(Types::Span<const char, BLOCK_SIZE>(adpcm.Data() + i * BLOCK_SIZE), Types::Span<int16_t, BLOCK_SAMPLES>(out + i * BLOCK_SAMPLES));
+}
+
+std::vector<std::shared_ptr<Data>> Load(const INT::INT &int_file)
+{
+	std::vector<std::shared_ptr<Data>> vabs;
+	for (auto &name : int_file.VABs())
+	{
+		INT::Member vab_file = int_file.Open(name);
+		if (!vab_file)
+			throw Types::RuntimeException("VAB not found in INT");
+		vabs.emplace_back(std::make_shared<Data>(vab_file));
+	}
+	return vabs;
+}
+
+// Bank
+Bank::Bank(const INT::INT &int_file) : Bank(Load(int_file))
+{
+
+}
+
+Bank::Bank(std::vector<std::shared_ptr<Data>> _vabs) : vabs(std::move(_vabs))
+{
+	// Lay out every waveform in the arena
+	std::vector<Types::Span<const char>> sources;
+
+	for (auto &vab : vabs)
+	{
+		waveform_base.push_back(waveforms.size());
+
+		for (uint16_t i = 0; i < vab->vags_size; i++)
+		{
+			auto adpcm = vab->GetADPCM(vab->vags[i]);
+
+			Waveform waveform;
+			waveform.offset = static_cast<uint32_t>(arena_size);
+			waveform.layout = Layout::Scan(adpcm);
+			arena_size += waveform.layout.length;
+
+			waveforms.push_back(waveform);
+			sources.push_back(adpcm);
+		}
+	}
+
+	// Waveforms decode independently, so they can all be done at once
+	arena = std::make_unique_for_overwrite<int16_t[]>(arena_size);
+
+	Jobs::Backend::Instance().ParallelFor(waveforms.size(), [&](size_t i)
+	{
+		Decode(sources[i], waveforms[i].layout, arena.get() + waveforms[i].offset);
+	});
+}
+
+size_t Bank::VABs() const
+{
+	return vabs.size();
+}
+
+const Data &Bank::GetVAB(size_t vab) const
+{
+	return *vabs.at(vab);
+}
+
+const Bank::Waveform *Bank::Find(size_t vab, size_t vag) const
+{
+	if (vab >= vabs.size() || vag == 0 || vag > vabs[vab]->vags_size)
+		return nullptr;
+	return &waveforms[waveform_base[vab] + vag - 1];
+}
+
+Types::Span<const int16_t> Bank::GetPCM(const Waveform &waveform) const
+{
+	return Types::Span<const int16_t>(arena.get() + waveform.offset, waveform.layout.length);
+}
+
+size_t Bank::Bytes() const
+{
+	return arena_size * sizeof(int16_t);
+}
+
+// Cache
+Cache::Cache(const INT::INT &int_file, const Config &config) : vabs(Load(int_file)), budget_bytes(config.budget_bytes)
+{
+
+}
+
+Cache::Cache(const INT::INT &int_file) : Cache(int_file, Config())
+{
+
+}
+
+size_t Cache::VABs() const
+{
+	return vabs.size();
+}
+
+const Data &Cache::GetVAB(size_t vab) const
+{
+	return *vabs.at(vab);
+}
+
+std::shared_ptr<const Sample> Cache::Get(size_t vab, size_t vag)
+{
+	if (vab >= vabs.size() || vag == 0 || vag > vabs[vab]->vags_size)
+		return nullptr;
+
+	uint32_t key = static_cast<uint32_t>((vab << 16) | vag);
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	// Move hits to the front
+	auto it = entries.find(key);
+	if (it != entries.end())
+	{
+		stats.hits++;
+		lru.splice(lru.begin(), lru, it->second.lru_it);
+		return it->second.sample;
+	}
+
+	// Decode the waveform
+	stats.misses++;
+
+	auto adpcm = vabs[vab]->GetADPCM(vabs[vab]->vags[vag - 1]);
+
+	auto sample = std::make_shared<Sample>();
+	sample->layout = Layout::Scan(adpcm);
+	sample->pcm = std::make_unique_for_overwrite<int16_t[]>(sample->layout.length);
+	Decode(adpcm, sample->layout, sample->pcm.get());
+
+	lru.push_front(key);
+	entries.emplace(key, Entry{ sample, lru.begin() });
+	stats.bytes += sample->layout.length * sizeof(int16_t);
+
+	Evict();
+	return sample;
+}
+
+void Cache::Evict()
+{
+	// The most recent sample is always kept, even if it's over budget by itself
+	while (stats.bytes > budget_bytes && lru.size() > 1)
+	{
+		auto it = entries.find(lru.back());
+		stats.bytes -= it->second.sample->layout.length * sizeof(int16_t);
+		stats.evictions++;
+
+		entries.erase(it);
+		lru.pop_back();
+	}
+}
+
+void Cache::SetBudget(size_t _budget_bytes)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	budget_bytes = _budget_bytes;
+	Evict();
+}
+
+void Cache::Clear()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	stats.evictions += entries.size();
+	stats.bytes = 0;
+	entries.clear();
+	lru.clear();
+}
+
+Cache::Stats Cache::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return stats;
+}
+
+// Sample source
+size_t SampleSource::Read(int16_t *out, size_t frames)
+{
+	size_t written = 0;
+	while (written < frames && position < layout.length)
+	{
+		// Copy mono samples to both sides
+		size_t count = std::min<size_t>(frames - written, layout.length - position);
+
+		const int16_t *src = pcm.Data() + position;
+		for (size_t i = 0; i < count; i++)
+		{
+			out[0] = src[i];
+			out[1] = src[i];
+			out += 2;
+		}
+
+		written += count;
+		position += count;
+
+		// Jump back to the loop start
+		if (position == layout.length && layout.loop)
+			position = layout.loop_start;
+	}
+
+	return written;
+}
+
+uint32_t SampleSource::GetFrequency() const
+{
+	return SPU_FREQUENCY;
+}
+
+}
@@ -0,0 +1,260 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "Backend/Audio/Mixer.h"
+
+#include "Types/File.h"
+#include "Types/Span.h"
+
+#include "PS1/INT.h"
+
+namespace PaperPup::VAB
+{
+
+// VAB file structures
+struct Header
+{
+	char form[4]; // = "pBAV"
+	uint32_t version;
+	uint32_t id;
+	uint32_t file_size;
+	uint16_t reserved0;
+	uint16_t programs;
+	uint16_t tones;
+	uint16_t vags;
+	uint8_t volume;
+	uint8_t pan;
+	uint8_t attr1, attr2;
+	uint32_t reserved1;
+};
+static_assert(sizeof(Header) == 32);
+static_assert(alignof(Header) <= 4);
+
+struct ProgramAttributes
+{
+	uint8_t tones;
+	uint8_t volume;
+	uint8_t priority;
+	uint8_t mode;
+	uint8_t pan;
+	uint8_t reserved0;
+	uint16_t attr;
+	uint32_t reserved1;
+	uint32_t reserved2;
+};
+static_assert(sizeof(ProgramAttributes) == 16);
+static_assert(alignof(ProgramAttributes) <= 4);
+
+struct ToneAttributes
+{
+	uint8_t priority;
+	uint8_t mode;
+	uint8_t volume;
+	uint8_t pan;
+	uint8_t center; // Note the waveform plays at 44100Hz on
+	uint8_t shift; // Fine tuning of the center note
+	uint8_t min, max; // Note range
+	uint8_t vibrato_width, vibrato_time;
+	uint8_t portamento_width, portamento_time;
+	uint8_t pitch_bend_min, pitch_bend_max;
+	uint8_t reserved1, reserved2;
+	uint16_t adsr1, adsr2;
+	int16_t program;
+	int16_t vag; // 1-based
+	int16_t reserved[4];
+};
+static_assert(sizeof(ToneAttributes) == 32);
+static_assert(alignof(ToneAttributes) <= 2);
+
+static constexpr size_t PROGRAMS_MAX = 128;
+static constexpr size_t PROGRAM_TONES = 16;
+static constexpr size_t VAGS_MAX = 256;
+
+// SPU ADPCM
+static constexpr size_t BLOCK_SIZE = 16;
+static constexpr size_t BLOCK_SAMPLES = 28;
+
+static constexpr uint32_t SPU_FREQUENCY = 44100;
+
+enum BlockFlags
+{
+	BlockFlag_LoopEnd = (1 << 0), // Last block of the waveform, or of its loop
+	BlockFlag_Repeat = (1 << 1), // At the loop end, jump back to the loop start instead of stopping
+	BlockFlag_LoopStart = (1 << 2),
+};
+
+// Data class
+struct Data
+{
+	Header header;
+	std::unique_ptr<ProgramAttributes[]> programs; // PROGRAMS_MAX
+	std::unique_ptr<ToneAttributes[]> tones; // PROGRAM_TONES per used program
+
+	// Copy of the SPU ADPCM body
+	std::unique_ptr<char[]> adpcm;
+
+	struct VAG
+	{
+		uint32_t offset; // Into `adpcm`
+		uint32_t size;
+	};
+	std::unique_ptr<VAG[]> vags; // 0-based, so VAG n is at n - 1
+	uint16_t vags_size;
+
+	Data(const Types::File &vab_file);
+
+	Types::Span<const char> GetADPCM(const VAG &vag) const
+	{
+		return Types::Span<const char>(adpcm.get() + vag.offset, vag.size);
+	}
+};
+
+// Shape of a waveform, from scanning the flags of its blocks
+struct Layout
+{
+	uint32_t length; // Samples up to and including the block with the loop end flag
+	uint32_t loop_start;
+	bool loop;
+
+	static Layout Scan(Types::Span<const char> adpcm);
+};
+
+// Decodes a whole waveform, `out` must hold `layout.length` samples
+void Decode(Types::Span<const char> adpcm, const Layout &layout, int16_t *out);
+
+// Loads every VAB of an INT
+std::vector<std::shared_ptr<Data>> Load(const INT::INT &int_file);
+
+// Decoded waveform
+struct Sample
+{
+	Layout layout;
+	std::unique_ptr<int16_t[]> pcm;
+
+	Types::Span<const int16_t> GetPCM() const
+	{
+		return Types::Span<const int16_t>(pcm.get(), layout.length);
+	}
+};
+
+// Every waveform of an INT's VABs, predecoded into one PCM arena
+class Bank
+{
+public:
+	struct Waveform
+	{
+		uint32_t offset; // Into the arena
+		Layout layout;
+	};
+
+private:
+	std::vector<std::shared_ptr<Data>> vabs;
+
+	// Waveforms of each VAB start at their VAB's base
+	std::vector<size_t> waveform_base;
+	std::vector<Waveform> waveforms;
+
+	std::unique_ptr<int16_t[]> arena;
+	size_t arena_size = 0;
+
+public:
+	// Decodes waveforms in parallel on the job backend
+	Bank(const INT::INT &int_file);
+	Bank(std::vector<std::shared_ptr<Data>> _vabs);
+
+	size_t VABs() const;
+	const Data &GetVAB(size_t vab) const;
+
+	// Finds a waveform by 1-based VAG number, or nullptr if it doesn't exist
+	const Waveform *Find(size_t vab, size_t vag) const;
+
+	Types::Span<const int16_t> GetPCM(const Waveform &waveform) const;
+
+	// Total PCM bytes held
+	size_t Bytes() const;
+};
+
+// Decodes waveforms of an INT's VABs on first use, and keeps the most recently used ones up to a byte budget
+// Samples stay alive while something holds on to them, even after being evicted
+// Safe to use from any thread but the audio thread
+class Cache
+{
+public:
+	struct Config
+	{
+		size_t budget_bytes = 16 * 1024 * 1024;
+	};
+
+	struct Stats
+	{
+		uint64_t hits;
+		uint64_t misses;
+		uint64_t evictions;
+		size_t bytes; // PCM bytes currently cached
+	};
+
+private:
+	std::vector<std::shared_ptr<Data>> vabs;
+
+	size_t budget_bytes;
+
+	// Keyed by VAB index and VAG number, most recently used at the front of `lru`
+	std::list<uint32_t> lru;
+
+	struct Entry
+	{
+		std::shared_ptr<const Sample> sample;
+		std::list<uint32_t>::iterator lru_it;
+	};
+	std::unordered_map<uint32_t, Entry> entries;
+
+	mutable std::mutex mutex;
+	Stats stats = {};
+
+	void Evict();
+
+public:
+	Cache(const INT::INT &int_file, const Config &config);
+	Cache(const INT::INT &int_file);
+
+	size_t VABs() const;
+	const Data &GetVAB(size_t vab) const;
+
+	// Gets a waveform by 1-based VAG number, decoding it if it isn't cached, or nullptr if it doesn't exist
+	std::shared_ptr<const Sample> Get(size_t vab, size_t vag);
+
+	// Evicts until the cache fits in a new budget
+	void SetBudget(size_t _budget_bytes);
+	void Clear();
+
+	Stats GetStats() const;
+};
+
+// Plays one waveform as a mixer source
+class SampleSource : public Audio::Source
+{
+private:
+	Types::Span<const int16_t> pcm;
+	Layout layout = {};
+
+	// Keeps a cached sample alive while playing
+	std::shared_ptr<const Sample> sample;
+
+	size_t position = 0;
+
+public:
+	SampleSource() = default;
+	SampleSource(Types::Span<const int16_t> _pcm, const Layout &_layout) : pcm(_pcm), layout(_layout) {}
+	SampleSource(const std::shared_ptr<const Sample> &_sample) : pcm(_sample->GetPCM()), layout(_sample->layout), sample(_sample) {}
+
+	size_t Read(int16_t *out, size_t frames) override;
+	uint32_t GetFrequency() const override;
+};
+
+}
@@ -67,6 +67,9 @@ Data::Data(const Types::File &vdf_file, const Types::File &dat_file)
 		// Read keyframe data
 		auto &keyframe = keyframes[i];
 
+		keyframe.vertex_p = vertex_p;
+		keyframe.weight_p = weight_p;
+
 		auto vdf_span = vdf_file.GetSubspan<Vertex>(vdf_p + sizeof(KeyHeader), keyframe.vertex_size);
 		auto dat_span = dat_file.GetSubspan<int16_t>(dat_p + sizeof(DAT::KeyHeader), keyframe.frames);
 
@@ -1,11 +1,368 @@
 #include "PS1/VDFActor.h"
 
+#include <algorithm>
+
 namespace PaperPup
 {
 
-VDFActor::VDFActor(const std::shared_ptr<TMD::Data> &_tmd_data, const std::shared_ptr<VDF::Data> &_vdf_data) : TMD::Model(_tmd_data), vdf_data(_vdf_data)
+// Runs closer than this many vertices are uploaded as one, since the extra bytes cost less than another call
+static constexpr uint32_t COALESCE_GAP = 16;
+
+static std::shared_ptr<const TMD::Baked> BakeMeshes(const TMD::Data &tmd_data)
+{
+	std::vector<TMD::MeshData> meshes;
+	for (uint32_t i = 0; i < tmd_data.objects_size; i++)
+		meshes.emplace_back(TMD::BuildMesh(tmd_data.objects[i]));
+	TMD::ReportUnsupported(meshes);
+
+	return TMD::Bake(meshes, 0, 0);
+}
+
+VDFActor::VDFActor(const std::shared_ptr<TMD::Data> &_tmd_data, const std::shared_ptr<VDF::Data> &_vdf_data) : VDFActor(_tmd_data, _vdf_data, *BakeMeshes(*_tmd_data))
+{
+
+}
+
+VDFActor::VDFActor(const std::shared_ptr<TMD::Data> &_tmd_data, const std::shared_ptr<VDF::Data> &_vdf_data, const TMD::Baked &baked) : TMD::Model(_tmd_data, baked), vdf_data(_vdf_data), morph(*_tmd_data, _vdf_data)
+{
+	morphed.resize(morph.Size());
+
+	// Find where every mesh vertex comes from
+	const int16_t *base = morph.GetBase();
+	for (uint32_t i = 0; i < tmd_data->objects_size; i++)
+	{
+		auto &baked_object = baked.objects[i];
+		auto vertex_sources = baked.vertex_sources.Slice(baked_object.base_vertex, baked_object.vertex_size);
+
+		uint32_t offset = static_cast<uint32_t>(morph.GetOffset(i));
+		uint32_t stride = morph.GetStride(i);
+		for (size_t j = 0; j < vertex_sources.Size(); j++)
+		{
+			if (vertex_sources[j] >= tmd_data->objects[i].vertex_size)
+				throw Types::RuntimeException("Baked vertex source out of range");
+
+			uint32_t index = offset + vertex_sources[j];
+			const auto &position = baked.vertices[baked_object.base_vertex + j].position;
+
+			VertexMorph vertex_morph;
+			vertex_morph.bias = {
+				static_cast<int16_t>(position.x - base[index]),
+				static_cast<int16_t>(position.y - base[index + stride]),
+				static_cast<int16_t>(position.z - base[index + stride * 2]),
+			};
+			vertex_morph.index = index;
+			vertex_morph.stride = stride;
+
+			vertex_morphs.push_back(vertex_morph);
+			rest_positions.push_back(position);
+		}
+	}
+
+	// Find the mesh vertices every target moves
+	target_runs.resize(morph.Targets());
+	for (size_t i = 0; i < morph.Targets(); i++)
+	{
+		auto &keyframe = vdf_data->keyframes[i];
+		auto &baked_object = baked.objects[keyframe.object_id];
+		auto vertex_sources = baked.vertex_sources.Slice(baked_object.base_vertex, baked_object.vertex_size);
+
+		auto &runs = target_runs[i];
+		for (size_t j = 0; j < vertex_sources.Size(); j++)
+		{
+			uint32_t source = vertex_sources[j];
+			if (source < keyframe.vertex_start || source - keyframe.vertex_start >= keyframe.vertex_size)
+				continue;
+
+			uint32_t vertex = baked_object.base_vertex + static_cast<uint32_t>(j);
+			if (!runs.empty() && runs.back().first + runs.back().size == vertex)
+				runs.back().size++;
+			else
+				runs.push_back({ vertex, 1 });
+		}
+	}
+
+	// There's always at least one pose to draw
+	NewPose();
+}
+
+VDFActor::Pose &VDFActor::NewPose()
 {
+	// Poses start out at rest, and are written whole by the next Upload so it's counted there
+	auto pose = std::make_unique<Pose>();
+	pose->positions = rest_positions;
+	if (!pose->positions.empty())
+		pose->dirty.push_back({ 0, static_cast<uint32_t>(pose->positions.size()) });
+
+	glGenBuffers(1, pose->vbo_id.GetAddressOf());
+	glBindBuffer(GL_ARRAY_BUFFER, pose->vbo_id.Get());
+	glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(pose->positions.size() * sizeof(TMD::MeshVertex::Position)), nullptr, GL_DYNAMIC_DRAW);
+
+	poses.emplace_back(std::move(pose));
+	return *poses.back();
+}
+
+void VDFActor::MorphPose(Pose &pose, uint32_t frame)
+{
+	morph.Evaluate(frame, morphed.data());
+
+	// Targets weighted on the old frame have to be put back even if they aren't weighted now
+	std::vector<Run> runs = std::move(pose.dirty);
+	for (size_t i : pose.active)
+		runs.insert(runs.end(), target_runs[i].begin(), target_runs[i].end());
+
+	pose.frame = frame;
+	pose.active.clear();
+	for (size_t i = 0; i < morph.Targets(); i++)
+	{
+		if (morph.GetWeight(i, frame) != 0)
+		{
+			pose.active.push_back(i);
+			runs.insert(runs.end(), target_runs[i].begin(), target_runs[i].end());
+		}
+	}
+
+	// Merge overlapping and nearby runs
+	std::sort(runs.begin(), runs.end(), [](const Run &a, const Run &b) { return a.first < b.first; });
+
+	pose.dirty.clear();
+	for (auto &run : runs)
+	{
+		if (!pose.dirty.empty() && run.first <= pose.dirty.back().first + pose.dirty.back().size + COALESCE_GAP)
+		{
+			uint32_t end = std::max(pose.dirty.back().first + pose.dirty.back().size, run.first + run.size);
+			pose.dirty.back().size = end - pose.dirty.back().first;
+		}
+		else
+		{
+			pose.dirty.push_back(run);
+		}
+	}
+
+	// Gather the dirty mesh positions
+	for (auto &run : pose.dirty)
+	{
+		for (uint32_t i = run.first; i < run.first + run.size; i++)
+		{
+			const VertexMorph &vertex_morph = vertex_morphs[i];
+			const int16_t *x = morphed.data() + vertex_morph.index;
+			pose.positions[i] = {
+				static_cast<int16_t>(vertex_morph.bias.x + x[0]),
+				static_cast<int16_t>(vertex_morph.bias.y + x[vertex_morph.stride]),
+				static_cast<int16_t>(vertex_morph.bias.z + x[vertex_morph.stride * 2]),
+			};
+		}
+	}
+}
+
+uint16_t VDFActor::Frames() const
+{
+	return morph.Frames();
+}
+
+void VDFActor::Advance(Types::Span<Cursor> cursors) const
+{
+	uint32_t frames = std::max<uint32_t>(morph.Frames(), 1);
+	for (auto &c : cursors)
+		c.frame = (c.frame + c.speed) % frames;
+}
+
+void VDFActor::Evaluate(Types::Span<Cursor> cursors)
+{
+	// Nothing to evaluate, and the poses are left alone so there's still one to draw
+	if (cursors.Size() == 0)
+		return;
+	generation++;
+
+	// Find the distinct frames
+	batch_frames.clear();
+	for (auto &c : cursors)
+		batch_frames.push_back(c.frame);
+	std::sort(batch_frames.begin(), batch_frames.end());
+	batch_frames.erase(std::unique(batch_frames.begin(), batch_frames.end()), batch_frames.end());
+
+	// Past the limit, only evenly spread frames get a pose, and cursors share the one at or before their frame
+	// The first frame is always kept, so every cursor has one
+	if (batch_frames.size() > pose_limit)
+	{
+		size_t distinct = batch_frames.size();
+		for (size_t i = 0; i < pose_limit; i++)
+			batch_frames[i] = batch_frames[i * distinct / pose_limit];
+		batch_frames.resize(pose_limit);
+	}
+
+	// Keep poses that are already on one of them
+	batch_poses.assign(batch_frames.size(), POSE_NONE);
+	pose_used.assign(poses.size(), false);
+
+	for (size_t i = 0; i < poses.size(); i++)
+	{
+		auto it = std::lower_bound(batch_frames.begin(), batch_frames.end(), poses[i]->frame);
+		if (it == batch_frames.end() || *it != poses[i]->frame)
+			continue;
+
+		size_t slot = static_cast<size_t>(it - batch_frames.begin());
+		if (batch_poses[slot] == POSE_NONE)
+		{
+			batch_poses[slot] = static_cast<uint16_t>(i);
+			pose_used[i] = true;
+		}
+	}
+
+	// Move unused poses to the frames left, making more if there aren't enough
+	size_t free_pose = 0;
+	for (size_t i = 0; i < batch_frames.size(); i++)
+	{
+		if (batch_poses[i] != POSE_NONE)
+			continue;
 
+		while (free_pose < pose_used.size() && pose_used[free_pose])
+			free_pose++;
+
+		if (free_pose == pose_used.size())
+		{
+			if (poses.size() >= POSE_NONE)
+				throw Types::RuntimeException("VDF actor has too many poses");
+			NewPose();
+			pose_used.push_back(false);
+		}
+
+		pose_used[free_pose] = true;
+		batch_poses[i] = static_cast<uint16_t>(free_pose);
+		MorphPose(*poses[free_pose], batch_frames[i]);
+	}
+
+	// Poses left over are kept while there's room for them, and released once they've been left over for too long
+	// Every frame has a pose at this point, and there are never more frames than the limit
+	size_t spare = pose_limit - batch_frames.size();
+	pose_remap.assign(poses.size(), POSE_NONE);
+
+	size_t kept = 0;
+	for (size_t i = 0; i < poses.size(); i++)
+	{
+		if (pose_used[i])
+		{
+			poses[i]->idle = 0;
+		}
+		else
+		{
+			if (spare == 0 || ++poses[i]->idle > POSE_IDLE_EVALUATIONS)
+				continue;
+			spare--;
+		}
+
+		pose_remap[i] = static_cast<uint16_t>(kept);
+		if (kept != i)
+			poses[kept] = std::move(poses[i]);
+		kept++;
+	}
+	poses.resize(kept);
+
+	for (auto &pose : batch_poses)
+		pose = pose_remap[pose];
+
+	// Point every cursor at its pose
+	for (auto &c : cursors)
+	{
+		c.pose = batch_poses[static_cast<size_t>(std::upper_bound(batch_frames.begin(), batch_frames.end(), c.frame) - batch_frames.begin()) - 1];
+		c.generation = generation;
+	}
+}
+
+void VDFActor::Upload()
+{
+	frame_stats = {};
+
+	size_t buffer_bytes = rest_positions.size() * sizeof(TMD::MeshVertex::Position);
+	for (auto &pose : poses)
+	{
+		if (pose->dirty.empty())
+			continue;
+
+		glBindBuffer(GL_ARRAY_BUFFER, pose->vbo_id.Get());
+
+		size_t dirty_bytes = 0;
+		for (auto &run : pose->dirty)
+			dirty_bytes += run.size * sizeof(TMD::MeshVertex::Position);
+
+		// Writing most of a buffer in place can stall on draws still reading it, so give it new storage and write it whole
+		if (dirty_bytes * 2 >= buffer_bytes)
+		{
+			glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(buffer_bytes), nullptr, GL_DYNAMIC_DRAW);
+			glBufferSubData(GL_ARRAY_BUFFER, 0, static_cast<GLsizeiptr>(buffer_bytes), pose->positions.data());
+
+			frame_stats.bytes += buffer_bytes;
+			frame_stats.ranges++;
+			frame_stats.orphans++;
+		}
+		else
+		{
+			for (auto &run : pose->dirty)
+				glBufferSubData(GL_ARRAY_BUFFER, static_cast<GLintptr>(run.first * sizeof(TMD::MeshVertex::Position)), static_cast<GLsizeiptr>(run.size * sizeof(TMD::MeshVertex::Position)), pose->positions.data() + run.first);
+
+			frame_stats.bytes += dirty_bytes;
+			frame_stats.ranges += pose->dirty.size();
+		}
+
+		pose->dirty.clear();
+	}
+
+	total_stats.bytes += frame_stats.bytes;
+	total_stats.ranges += frame_stats.ranges;
+	total_stats.orphans += frame_stats.orphans;
+}
+
+const VDFActor::Pose &VDFActor::GetPose(const Cursor &_cursor) const
+{
+	// A cursor from an earlier call could point at a pose that's since moved or been released
+	if (_cursor.generation != generation)
+		throw Types::RuntimeException("VDF actor cursor wasn't in the last Evaluate");
+	return *poses.at(_cursor.pose);
+}
+
+void VDFActor::Draw(const Cursor &_cursor) const
+{
+	// Point the model's positions at the pose
+	glBindVertexArray(vao_id.Get());
+	glBindBuffer(GL_ARRAY_BUFFER, GetPose(_cursor).vbo_id.Get());
+	glVertexAttribIPointer(0, 3, GL_SHORT, sizeof(TMD::MeshVertex::Position), nullptr);
+
+	TMD::Model::Draw();
+}
+
+void VDFActor::Evaluate(uint32_t frame)
+{
+	cursor.frame = frame;
+	Evaluate(Types::Span<Cursor>(&cursor, 1));
+}
+
+void VDFActor::Draw() const
+{
+	Draw(cursor);
+}
+
+const std::vector<TMD::MeshVertex::Position> &VDFActor::GetPositions() const
+{
+	return GetPose(cursor).positions;
+}
+
+VDFActor::UploadStats VDFActor::GetFrameUploadStats() const
+{
+	return frame_stats;
+}
+
+VDFActor::UploadStats VDFActor::GetTotalUploadStats() const
+{
+	return total_stats;
+}
+
+size_t VDFActor::Poses() const
+{
+	return poses.size();
+}
+
+void VDFActor::SetPoseLimit(size_t _pose_limit)
+{
+	pose_limit = std::clamp<size_t>(_pose_limit, 1, POSE_NONE - 1);
 }
 
 }
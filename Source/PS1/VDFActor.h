@@ -3,25 +3,150 @@
 #include "Backend/Render.h"
 
 #include "Types/File.h"
+#include "Types/Span.h"
 #include "Types/UniqueGLInstance.h"
 
-#include "PS1/TMD.h"
+#include "PS1/TMDModel.h"
 #include "PS1/VDF.h"
+#include "PS1/VDFMorph.h"
 
 #include <memory>
+#include <vector>
 
 namespace PaperPup
 {
 
+// TMD model morphed by a VDF, shared by every instance playing it
+// Instances only carry a cursor, and every distinct frame they're on is morphed into one pose shared by all of them
+// Poses keep their own position buffer, and moving one to another frame only uploads the vertices of targets weighted on either frame
+// There are never more poses than the pose limit, past it instances are drawn with the pose of a nearby earlier frame
+// Poses no instance is on are kept to be moved to the next new frame, and only released once they've gone unused for a while,
+// so memory follows the recent spread of frames without instances meeting and splitting up making new buffers every time
 class VDFActor : public TMD::Model
 {
+public:
+	// Playback state of one instance
+	struct Cursor
+	{
+		uint32_t frame = 0;
+		uint16_t speed = 1; // Frames advanced per Advance call
+		uint16_t pose = 0; // Set by Evaluate
+		uint32_t generation = 0; // Of the Evaluate call that set `pose`
+	};
+
+	// Poses kept at most by default
+	static constexpr size_t POSE_LIMIT = 32;
+
+	// Evaluate calls a pose no cursor is on is kept for
+	static constexpr uint32_t POSE_IDLE_EVALUATIONS = 120;
+
+	struct UploadStats
+	{
+		uint64_t bytes;
+		uint64_t ranges; // glBufferSubData calls, or 1 per orphaned buffer
+		uint64_t orphans;
+	};
+
 private:
 	std::shared_ptr<VDF::Data> vdf_data;
 
-	Types::UniqueGLInstance<GLuint, decltype(glDeleteBuffers), &glDeleteBuffers, false> vbo_id;
+	VDF::Morph morph;
+	std::vector<int16_t> morphed;
+
+	// Where each mesh vertex is gathered from
+	// Vertices are offset by how far their object vertex moved rather than set to it, since sprite corners aren't on their vertex
+	struct VertexMorph
+	{
+		TMD::MeshVertex::Position bias; // Mesh position minus the object vertex's base position
+		uint32_t index; // Of the object vertex's x, in evaluated positions
+		uint32_t stride;
+	};
+	std::vector<VertexMorph> vertex_morphs;
+	std::vector<TMD::MeshVertex::Position> rest_positions;
+
+	// Runs of mesh vertices each target moves
+	struct Run
+	{
+		uint32_t first;
+		uint32_t size;
+	};
+	std::vector<std::vector<Run>> target_runs;
+
+	// Mesh positions at one frame
+	static constexpr uint32_t FRAME_NONE = 0xFFFFFFFF;
+
+	struct Pose
+	{
+		uint32_t frame = FRAME_NONE;
+		std::vector<size_t> active; // Targets weighted on `frame`
+
+		std::vector<TMD::MeshVertex::Position> positions;
+		std::vector<Run> dirty; // Not yet uploaded
+		uint32_t idle = 0; // Evaluate calls since a cursor was last on it
+
+		Types::UniqueGLInstance<GLuint, decltype(glDeleteBuffers), &glDeleteBuffers, false> vbo_id;
+	};
+	std::vector<std::unique_ptr<Pose>> poses;
+	size_t pose_limit = POSE_LIMIT;
+
+	static constexpr uint16_t POSE_NONE = 0xFFFF;
+
+	// Scratch for batches
+	std::vector<uint32_t> batch_frames;
+	std::vector<uint16_t> batch_poses;
+	std::vector<bool> pose_used;
+	std::vector<uint16_t> pose_remap;
+
+	// Bumped by every Evaluate call, since poses move between them
+	uint32_t generation = 0;
+
+	// Used by the single instance calls
+	Cursor cursor;
+
+	UploadStats frame_stats = {};
+	UploadStats total_stats = {};
+
+	// Morphing needs the meshes' vertex sources and positions, which the model doesn't keep
+	VDFActor(const std::shared_ptr<TMD::Data> &_tmd_data, const std::shared_ptr<VDF::Data> &_vdf_data, const TMD::Baked &baked);
+
+	Pose &NewPose();
+	void MorphPose(Pose &pose, uint32_t frame);
+	const Pose &GetPose(const Cursor &_cursor) const;
 
 public:
 	VDFActor(const std::shared_ptr<TMD::Data> &_tmd_data, const std::shared_ptr<VDF::Data> &_vdf_data);
+
+	uint16_t Frames() const;
+
+	// Moves every cursor forward by its speed, looping at the end
+	void Advance(Types::Span<Cursor> cursors) const;
+
+	// Morphs a pose for every distinct frame the cursors are on, up to the pose limit, and points each cursor at its pose
+	// Poses already on a frame are reused as is, so instances in step cost nothing extra
+	// Poses none of the cursors are on are kept for later calls while there's room under the pose limit,
+	// and released after POSE_IDLE_EVALUATIONS calls without a cursor
+	void Evaluate(Types::Span<Cursor> cursors);
+
+	// Uploads what the last Evaluate calls changed
+	void Upload();
+
+	// Draws an instance with the pose its cursor was last evaluated to
+	// Every instance drawn has to go through the same, latest Evaluate call, this throws for a cursor left out of it
+	void Draw(const Cursor &_cursor) const;
+
+	// Single instance playback, Evaluate counts as its own call so it leaves every other cursor out
+	void Evaluate(uint32_t frame);
+	void Draw() const;
+	const std::vector<TMD::MeshVertex::Position> &GetPositions() const;
+
+	// Uploads by the last Upload call, and by every call so far
+	UploadStats GetFrameUploadStats() const;
+	UploadStats GetTotalUploadStats() const;
+
+	size_t Poses() const;
+
+	// Takes effect on the next Evaluate
+	void SetPoseLimit(size_t _pose_limit);
 };
 
 }
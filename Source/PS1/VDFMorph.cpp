@@ -0,0 +1,193 @@
+#include "PS1/VDFMorph.h"
+
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PAPERPUP_MORPH_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace PaperPup::VDF
+{
+
+// Kernels
+void AccumulateReference(int16_t *out, const int16_t *delta, int16_t weight, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		int32_t product = std::clamp<int32_t>((delta[i] * weight) >> 12, -0x8000, 0x7FFF);
+		out[i] = static_cast<int16_t>(out[i] + product);
+	}
+}
+
+#ifdef PAPERPUP_MORPH_SSE2
+void Accumulate(int16_t *out, const int16_t *delta, int16_t weight, size_t count)
+{
+	// Full 32-bit products are put back together from their low and high halves
+	const __m128i weights = _mm_set1_epi16(weight);
+
+	for (size_t i = 0; i < count; i += Morph::LANES)
+	{
+		__m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i *>(delta + i));
+		__m128i lo = _mm_mullo_epi16(d, weights);
+		__m128i hi = _mm_mulhi_epi16(d, weights);
+
+		__m128i product = _mm_packs_epi32(_mm_srai_epi32(_mm_unpacklo_epi16(lo, hi), 12), _mm_srai_epi32(_mm_unpackhi_epi16(lo, hi), 12));
+
+		__m128i *dst = reinterpret_cast<__m128i *>(out + i);
+		_mm_storeu_si128(dst, _mm_add_epi16(_mm_loadu_si128(dst), product));
+	}
+}
+#else
+void Accumulate(int16_t *out, const int16_t *delta, int16_t weight, size_t count)
+{
+	AccumulateReference(out, delta, weight, count);
+}
+#endif
+
+// Morph
+static uint32_t RoundUp(uint32_t x)
+{
+	return (x + (Morph::LANES - 1)) & ~static_cast<uint32_t>(Morph::LANES - 1);
+}
+
+Morph::Morph(const TMD::Data &tmd_data, const std::shared_ptr<const Data> &_vdf_data) : vdf_data(_vdf_data)
+{
+	// Lay out every object's positions
+	size_t size = 0;
+	for (uint32_t i = 0; i < tmd_data.objects_size; i++)
+	{
+		Object object;
+		object.vertex_size = tmd_data.objects[i].vertex_size;
+		object.stride = RoundUp(object.vertex_size);
+		object.offset = size;
+		size += object.stride * 3;
+
+		objects.push_back(object);
+	}
+
+	base.assign(size, 0);
+	for (uint32_t i = 0; i < tmd_data.objects_size; i++)
+	{
+		auto &object = objects[i];
+		const TMD::Vector *vertex_p = tmd_data.objects[i].vertex_p;
+
+		int16_t *x = base.data() + object.offset;
+		int16_t *y = x + object.stride;
+		int16_t *z = y + object.stride;
+		for (uint32_t j = 0; j < object.vertex_size; j++)
+		{
+			x[j] = vertex_p[j].x;
+			y[j] = vertex_p[j].y;
+			z[j] = vertex_p[j].z;
+		}
+	}
+
+	// Lay out every target's deltas on its object's lanes
+	size_t deltas_size = 0;
+	for (uint16_t i = 0; i < vdf_data->keyframes_size; i++)
+	{
+		auto &keyframe = vdf_data->keyframes[i];
+		if (keyframe.object_id >= objects.size())
+			throw Types::RuntimeException("VDF keyframe object out of range");
+		if (keyframe.vertex_start > objects[keyframe.object_id].vertex_size || keyframe.vertex_size > objects[keyframe.object_id].vertex_size - keyframe.vertex_start)
+			throw Types::RuntimeException("VDF keyframe vertices out of range");
+
+		Target target;
+		target.object = keyframe.object_id;
+		target.first = keyframe.vertex_start & ~static_cast<uint32_t>(LANES - 1);
+		target.size = RoundUp(keyframe.vertex_start + keyframe.vertex_size) - target.first;
+		target.offset = deltas_size;
+		target.weight_p = keyframe.weight_p;
+		target.frames = keyframe.frames;
+		deltas_size += target.size * 3;
+
+		targets.push_back(target);
+		frames = std::max(frames, keyframe.frames);
+	}
+
+	deltas.assign(deltas_size, 0);
+	for (size_t i = 0; i < targets.size(); i++)
+	{
+		auto &keyframe = vdf_data->keyframes[i];
+		auto &target = targets[i];
+
+		int16_t *x = deltas.data() + target.offset + (keyframe.vertex_start - target.first);
+		int16_t *y = x + target.size;
+		int16_t *z = y + target.size;
+		for (uint32_t j = 0; j < keyframe.vertex_size; j++)
+		{
+			x[j] = keyframe.vertex_p[j].x;
+			y[j] = keyframe.vertex_p[j].y;
+			z[j] = keyframe.vertex_p[j].z;
+		}
+	}
+}
+
+size_t Morph::Objects() const
+{
+	return objects.size();
+}
+
+uint32_t Morph::GetVertexSize(size_t object) const
+{
+	return objects.at(object).vertex_size;
+}
+
+uint32_t Morph::GetStride(size_t object) const
+{
+	return objects.at(object).stride;
+}
+
+size_t Morph::GetOffset(size_t object) const
+{
+	return objects.at(object).offset;
+}
+
+size_t Morph::Size() const
+{
+	return base.size();
+}
+
+uint16_t Morph::Frames() const
+{
+	return frames;
+}
+
+size_t Morph::Targets() const
+{
+	return targets.size();
+}
+
+int16_t Morph::GetWeight(size_t target, uint32_t frame) const
+{
+	const Target &t = targets.at(target);
+	return frame < t.frames ? t.weight_p[frame] : 0;
+}
+
+const int16_t *Morph::GetBase() const
+{
+	return base.data();
+}
+
+void Morph::Evaluate(uint32_t frame, int16_t *out) const
+{
+	std::copy(base.begin(), base.end(), out);
+
+	for (auto &target : targets)
+	{
+		// Most targets have no weight on any given frame
+		const int16_t weight = frame < target.frames ? target.weight_p[frame] : 0;
+		if (weight == 0)
+			continue;
+
+		const Object &object = objects[target.object];
+		const int16_t *delta = deltas.data() + target.offset;
+
+		int16_t *dst = out + object.offset + target.first;
+		for (size_t axis = 0; axis < 3; axis++)
+			Accumulate(dst + axis * object.stride, delta + axis * target.size, weight, target.size);
+	}
+}
+
+}
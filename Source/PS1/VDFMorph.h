@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "PS1/TMD.h"
+#include "PS1/VDF.h"
+
+namespace PaperPup::VDF
+{
+
+// Adds `(delta * weight) >> 12` to `out`, each product saturated to 16-bit before adding
+// `count` must be a multiple of Morph::LANES
+void Accumulate(int16_t *out, const int16_t *delta, int16_t weight, size_t count);
+
+// Scalar version of Accumulate, which it has to match exactly
+void AccumulateReference(int16_t *out, const int16_t *delta, int16_t weight, size_t count);
+
+// Morph targets of a VDF laid out against the TMD they animate
+// Positions are int16 structure of arrays, every object having an x, y and z run padded to a multiple of LANES
+// Targets are zero padded out to whole lanes, so kernels never need a tail
+class Morph
+{
+public:
+	static constexpr size_t LANES = 8;
+
+private:
+	std::shared_ptr<const Data> vdf_data;
+
+	struct Object
+	{
+		uint32_t vertex_size;
+		uint32_t stride; // Length of each axis run
+		size_t offset; // Into evaluated positions
+	};
+	std::vector<Object> objects;
+
+	// Unmorphed positions of every object
+	std::vector<int16_t> base;
+
+	struct Target
+	{
+		uint32_t object;
+		uint32_t first; // First vertex, rounded down to LANES
+		uint32_t size; // Length of each axis run
+		size_t offset; // Into `deltas`
+
+		const int16_t *weight_p;
+		uint16_t frames;
+	};
+	std::vector<Target> targets;
+	std::vector<int16_t> deltas;
+
+	uint16_t frames = 0;
+
+public:
+	Morph(const TMD::Data &tmd_data, const std::shared_ptr<const Data> &_vdf_data);
+
+	size_t Objects() const;
+	uint32_t GetVertexSize(size_t object) const;
+	uint32_t GetStride(size_t object) const;
+	size_t GetOffset(size_t object) const;
+
+	// Number of int16 values evaluated positions take up
+	size_t Size() const;
+
+	// Longest keyframe, targets past their own end have no weight
+	uint16_t Frames() const;
+
+	// Targets are in keyframe order
+	size_t Targets() const;
+	int16_t GetWeight(size_t target, uint32_t frame) const;
+
+	const int16_t *GetBase() const;
+
+	// Evaluates every object at `frame` into `out`, laid out like GetBase
+	void Evaluate(uint32_t frame, int16_t *out) const;
+};
+
+}
@@ -0,0 +1,238 @@
+#include "PS1/XAIndex.h"
+
+#include "Types/Exceptions.h"
+#include "Types/MmapFile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <unordered_map>
+
+namespace PaperPup::PS1
+{
+
+// Index file structures
+struct IndexHeader
+{
+	char magic[4]; // = "XAIX"
+	uint32_t version;
+	uint64_t source_size;
+	int64_t source_time;
+	uint32_t channels;
+	uint32_t entries;
+	uint32_t checkpoints;
+	uint32_t checkpoint_interval;
+};
+static_assert(sizeof(IndexHeader) == 40);
+
+static constexpr size_t SECTOR_SIZE = 0x920;
+
+XAIndex::XAIndex(const std::filesystem::path &xa_path, const std::filesystem::path &index_path)
+{
+	// The index is only valid for the exact file it was built from
+	uint64_t source_size = std::filesystem::file_size(xa_path);
+	int64_t source_time = static_cast<int64_t>(std::filesystem::last_write_time(xa_path).time_since_epoch().count());
+
+	if (Load(index_path, source_size, source_time))
+		return;
+
+	// Scan the XA file
+	Types::MmapFile xa_file(xa_path, Types::MmapFile::Access_Sequential);
+	auto xa_span = xa_file.GetSpan();
+	Build(Types::Span<const char>(xa_span.Data(), xa_span.Size()));
+	Save(index_path, source_size, source_time);
+}
+
+XAIndex::XAIndex(const std::filesystem::path &xa_path) : XAIndex(xa_path, std::filesystem::path(xa_path).concat(".IDX"))
+{
+
+}
+
+void XAIndex::Build(Types::Span<const char> xa_data)
+{
+	// Gather entries and checkpoints per channel, in the order channels first appear
+	struct Bucket
+	{
+		XADecode decoder;
+		std::vector<Entry> entries;
+		std::vector<Checkpoint> checkpoints;
+	};
+	std::vector<std::unique_ptr<Bucket>> buckets;
+	std::unordered_map<uint16_t, size_t> bucket_map;
+
+	auto sector_out = std::make_unique<XADecode::XASectorOut>();
+
+	uint32_t sectors = static_cast<uint32_t>(xa_data.Size() / SECTOR_SIZE);
+
+	for (uint32_t i = 0; i < sectors; i++)
+	{
+		const char *sector = xa_data.Data() + static_cast<size_t>(i) * SECTOR_SIZE;
+
+		// Sectors with mismatching subheaders don't decode to anything
+		const SubHeader *subheader = reinterpret_cast<const SubHeader *>(sector);
+		if (std::memcmp(&subheader[0], &subheader[1], sizeof(SubHeader)))
+			continue;
+
+		uint16_t key = static_cast<uint16_t>((subheader->file << 8) | subheader->channel);
+		auto [it, inserted] = bucket_map.try_emplace(key, buckets.size());
+		if (inserted)
+			buckets.emplace_back(std::make_unique<Bucket>());
+
+		Bucket &bucket = *buckets[it->second];
+
+		// Checkpoint the decoder before the sector
+		if (bucket.entries.size() % CHECKPOINT_INTERVAL == 0)
+			bucket.checkpoints.push_back({ static_cast<uint32_t>(bucket.entries.size()), bucket.decoder.GetState() });
+
+		// Decode the sector exactly like playback would to get its true frame count
+		bucket.decoder.DecodeXASector(Types::Span<const char, SECTOR_SIZE>(sector), *sector_out);
+
+		bucket.entries.push_back({ i, sector_out->samples_count, subheader->file, subheader->channel, subheader->codinginfo, 0 });
+	}
+
+	// Flatten channels and accumulate frame positions
+	for (auto &bucket : buckets)
+	{
+		Channel channel = {};
+		channel.file = bucket->entries.front().file;
+		channel.channel = bucket->entries.front().channel;
+		channel.entry_start = static_cast<uint32_t>(entries.size());
+		channel.entry_size = static_cast<uint32_t>(bucket->entries.size());
+		channel.sector_frames = bucket->entries.front().frame;
+		channel.checkpoint_start = static_cast<uint32_t>(checkpoints.size());
+		channel.checkpoint_size = static_cast<uint32_t>(bucket->checkpoints.size());
+
+		// Entry frames hold the sector's frame count until here
+		for (auto &entry : bucket->entries)
+		{
+			uint32_t sector_frames = entry.frame;
+			if (sector_frames != channel.sector_frames)
+				channel.sector_frames = 0;
+
+			entry.frame = static_cast<uint32_t>(channel.frames);
+			channel.frames += sector_frames;
+
+			entries.push_back(entry);
+		}
+
+		checkpoints.insert(checkpoints.end(), bucket->checkpoints.begin(), bucket->checkpoints.end());
+		channels.push_back(channel);
+	}
+}
+
+bool XAIndex::Load(const std::filesystem::path &index_path, uint64_t source_size, int64_t source_time)
+{
+	std::ifstream stream(index_path, std::ios::binary);
+	if (!stream)
+		return false;
+
+	// Check that the index is for this file and format
+	IndexHeader header;
+	if (!stream.read(reinterpret_cast<char *>(&header), sizeof(header)))
+		return false;
+
+	if (std::memcmp(header.magic, "XAIX", 4) || header.version != VERSION || header.source_size != source_size || header.source_time != source_time)
+		return false;
+	if (header.checkpoint_interval != CHECKPOINT_INTERVAL)
+		return false;
+
+	// Read index
+	channels.resize(header.channels);
+	entries.resize(header.entries);
+	checkpoints.resize(header.checkpoints);
+
+	stream.read(reinterpret_cast<char *>(channels.data()), static_cast<std::streamsize>(channels.size() * sizeof(Channel)));
+	stream.read(reinterpret_cast<char *>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(Entry)));
+	stream.read(reinterpret_cast<char *>(checkpoints.data()), static_cast<std::streamsize>(checkpoints.size() * sizeof(Checkpoint)));
+
+	bool valid = static_cast<bool>(stream);
+	for (auto &channel : channels)
+	{
+		if (channel.entry_start > entries.size() || entries.size() - channel.entry_start < channel.entry_size)
+			valid = false;
+		if (channel.checkpoint_start > checkpoints.size() || checkpoints.size() - channel.checkpoint_start < channel.checkpoint_size)
+			valid = false;
+		if (channel.checkpoint_size != (channel.entry_size + CHECKPOINT_INTERVAL - 1) / CHECKPOINT_INTERVAL)
+			valid = false;
+	}
+
+	if (!valid)
+	{
+		channels.clear();
+		entries.clear();
+		checkpoints.clear();
+	}
+	return valid;
+}
+
+void XAIndex::Save(const std::filesystem::path &index_path, uint64_t source_size, int64_t source_time) const
+{
+	IndexHeader header = {};
+	std::memcpy(header.magic, "XAIX", 4);
+	header.version = VERSION;
+	header.source_size = source_size;
+	header.source_time = source_time;
+	header.channels = static_cast<uint32_t>(channels.size());
+	header.entries = static_cast<uint32_t>(entries.size());
+	header.checkpoints = static_cast<uint32_t>(checkpoints.size());
+	header.checkpoint_interval = CHECKPOINT_INTERVAL;
+
+	std::ofstream stream(index_path, std::ios::binary);
+	stream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+	stream.write(reinterpret_cast<const char *>(channels.data()), static_cast<std::streamsize>(channels.size() * sizeof(Channel)));
+	stream.write(reinterpret_cast<const char *>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(Entry)));
+	stream.write(reinterpret_cast<const char *>(checkpoints.data()), static_cast<std::streamsize>(checkpoints.size() * sizeof(Checkpoint)));
+
+	// Failing to cache isn't fatal, the index is just rebuilt next time
+	if (!stream)
+		std::cout << "Failed to save XA index " << index_path.string() << std::endl;
+}
+
+const XAIndex::Channel *XAIndex::Find(uint8_t file, uint8_t channel) const
+{
+	for (auto &i : channels)
+	{
+		if (i.file == file && i.channel == channel)
+			return &i;
+	}
+	return nullptr;
+}
+
+Types::Span<const XAIndex::Entry> XAIndex::Entries(const Channel &channel) const
+{
+	return Types::Span<const Entry>(entries.data() + channel.entry_start, channel.entry_size);
+}
+
+const XAIndex::Entry *XAIndex::Locate(const Channel &channel, uint64_t frame) const
+{
+	if (frame >= channel.frames)
+		return nullptr;
+
+	auto channel_entries = Entries(channel);
+
+	// Constant size sectors can be indexed directly
+	if (channel.sector_frames != 0)
+		return &channel_entries[static_cast<size_t>(frame / channel.sector_frames)];
+
+	// Otherwise find the last sector starting at or before the frame
+	auto it = std::upper_bound(channel_entries.begin(), channel_entries.end(), frame, [](uint64_t f, const Entry &entry) { return f < entry.frame; });
+	return it - 1;
+}
+
+size_t XAIndex::EntryAt(const Channel &channel, uint32_t sector) const
+{
+	auto channel_entries = Entries(channel);
+	auto it = std::lower_bound(channel_entries.begin(), channel_entries.end(), sector, [](const Entry &entry, uint32_t s) { return entry.sector < s; });
+	return static_cast<size_t>(it - channel_entries.begin());
+}
+
+const XAIndex::Checkpoint &XAIndex::FindCheckpoint(const Channel &channel, size_t entry) const
+{
+	// Checkpoints are at a fixed interval, so the nearest one can be indexed directly
+	size_t checkpoint = std::min<size_t>(entry / CHECKPOINT_INTERVAL, channel.checkpoint_size - 1);
+	return checkpoints[channel.checkpoint_start + checkpoint];
+}
+
+}
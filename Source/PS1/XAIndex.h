@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+#include "PS1/ADPCM.h"
+
+#include "Types/Span.h"
+
+namespace PaperPup::PS1
+{
+
+// Index of every audio sector in an XA file, grouped by channel
+// Built once by decoding the whole file, then cached on disk
+// Alongside the sectors, the decoder state of each channel is checkpointed at regular intervals,
+// so a seek only has to decode from the nearest checkpoint to match linear playback exactly
+class XAIndex
+{
+public:
+	struct Entry
+	{
+		uint32_t sector; // Absolute sector number in the file
+		uint32_t frame; // Frame position of the sector's first sample within its channel
+		uint8_t file, channel;
+		uint8_t codinginfo;
+		uint8_t pad;
+	};
+	static_assert(sizeof(Entry) == 12);
+
+	struct Checkpoint
+	{
+		uint32_t entry; // Index of the channel entry the state is from before decoding
+		XADecode::State state;
+	};
+	static_assert(sizeof(Checkpoint) == 20);
+
+	struct Channel
+	{
+		uint8_t file, channel;
+
+		// Range of this channel's entries
+		uint32_t entry_start;
+		uint32_t entry_size;
+
+		// Frames decoded from each sector, or 0 if the format changes within the channel
+		uint32_t sector_frames;
+
+		// Range of this channel's checkpoints
+		uint32_t checkpoint_start;
+		uint32_t checkpoint_size;
+
+		uint64_t frames;
+	};
+
+	// Bumped whenever the cached format or its contents change
+	static constexpr uint32_t VERSION = 2;
+
+	// Number of channel sectors between checkpoints
+	static constexpr uint32_t CHECKPOINT_INTERVAL = 16;
+
+private:
+	std::vector<Entry> entries;
+	std::vector<Channel> channels;
+	std::vector<Checkpoint> checkpoints;
+
+	void Build(Types::Span<const char> xa_data);
+
+	bool Load(const std::filesystem::path &index_path, uint64_t source_size, int64_t source_time);
+	void Save(const std::filesystem::path &index_path, uint64_t source_size, int64_t source_time) const;
+
+public:
+	// Loads the index from `index_path` if it matches the XA file, otherwise scans the XA file and tries to save it there
+	XAIndex(const std::filesystem::path &xa_path, const std::filesystem::path &index_path);
+	// Caches the index next to the XA file
+	XAIndex(const std::filesystem::path &xa_path);
+
+	const Channel *Find(uint8_t file, uint8_t channel) const;
+
+	Types::Span<const Entry> Entries(const Channel &channel) const;
+
+	// Finds the entry of the sector containing a frame of a channel, or nullptr if it's past the end
+	const Entry *Locate(const Channel &channel, uint64_t frame) const;
+
+	// Finds the index of a channel's first entry at or after an absolute sector
+	size_t EntryAt(const Channel &channel, uint32_t sector) const;
+
+	// Finds the last checkpoint at or before a channel entry
+	const Checkpoint &FindCheckpoint(const Channel &channel, size_t entry) const;
+};
+
+}
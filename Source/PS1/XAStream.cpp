@@ -0,0 +1,263 @@
+#include "PS1/XAStream.h"
+
+#include "Types/Exceptions.h"
+
+#include <chrono>
+
+namespace PaperPup::PS1
+{
+
+// Sectors paged in ahead of the worker at a time
+static constexpr size_t READAHEAD_SECTORS = 64;
+
+XAStream::XAStream(const std::filesystem::path &path, const std::vector<ChannelID> &ids, const Config &config) :
+	file(path, Types::MmapFile::Access_Sequential),
+	sectors(file.GetSpan().Size() / SECTOR_SIZE),
+	xa_index(path)
+{
+
+	// Create channels
+	if (ids.empty())
+		throw Types::RuntimeException("XA stream needs at least one channel");
+
+	size_t capacity = std::max<size_t>(config.prefetch_sectors, 1) * SECTOR_FRAMES * 2;
+	for (auto &id : ids)
+	{
+		auto &channel = channels.emplace_back(std::make_unique<Channel>(id, capacity));
+		channel->index_channel = xa_index.Find(id.file, id.channel);
+	}
+
+	Start();
+}
+
+XAStream::XAStream(const std::filesystem::path &path, const std::vector<ChannelID> &ids) : XAStream(path, ids, Config())
+{
+
+}
+
+XAStream::~XAStream()
+{
+	Stop();
+}
+
+XAStream::Channel *XAStream::Route(const SubHeader &subheader) const
+{
+	for (auto &channel : channels)
+	{
+		if (channel->id.file == subheader.file && channel->id.channel == subheader.channel)
+			return channel.get();
+	}
+	return nullptr;
+}
+
+bool XAStream::ThreadSleep(int ms)
+{
+	auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(ms);
+	while (std::chrono::steady_clock::now() < end)
+	{
+		if (thread_quit)
+			return true;
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	return thread_quit;
+}
+
+void XAStream::Thread()
+{
+	static_assert(sizeof(sector_out.samples) == SECTOR_FRAMES * 2 * sizeof(int16_t));
+
+	const char *data = file.GetSpan().Data();
+
+	while (!thread_quit)
+	{
+		// Wait until every channel has room for a whole sector, since we don't know which one is next
+		bool full = false;
+		for (auto &channel : channels)
+		{
+			if (channel->ring.Writable() < SECTOR_FRAMES * 2)
+			{
+				full = true;
+				break;
+			}
+		}
+
+		if (full)
+		{
+			if (ThreadSleep(1))
+				break;
+			continue;
+		}
+
+		// Read the next sector and route it to its channel
+		if (next_sector >= sectors)
+			break;
+
+		const char *sector = data + next_sector * SECTOR_SIZE;
+		next_sector++;
+
+		// Page in what the sectors after this will need
+		if (next_sector % READAHEAD_SECTORS == 0)
+			file.WillNeed(next_sector * SECTOR_SIZE, READAHEAD_SECTORS * SECTOR_SIZE);
+
+		Channel *channel = Route(*reinterpret_cast<const SubHeader *>(sector));
+		if (channel == nullptr)
+			continue;
+
+		channel->decoder.DecodeXASector(Types::Span<const char, SECTOR_SIZE>(sector), sector_out);
+		if (sector_out.samples_count == 0)
+			continue;
+
+		// Push decoded frames
+		uint32_t skip = std::min(channel->skip_frames, sector_out.samples_count);
+		channel->skip_frames -= skip;
+
+		channel->sample_rate.store(sector_out.sample_rate, std::memory_order_relaxed);
+		channel->ring.Write(*sector_out.samples.data() + skip * 2, (sector_out.samples_count - skip) * 2);
+	}
+
+	thread_end.store(true, std::memory_order_release);
+}
+
+void XAStream::Start()
+{
+	thread_quit = false;
+	thread_end = false;
+
+	thread = std::thread([this]()
+		{
+			Thread();
+		}
+	);
+}
+
+void XAStream::Stop()
+{
+	thread_quit = true;
+	if (thread.joinable())
+		thread.join();
+}
+
+size_t XAStream::Channels() const
+{
+	return channels.size();
+}
+
+size_t XAStream::Read(size_t index, int16_t *out, size_t frames)
+{
+	Channel &channel = *channels[index];
+
+	// Check for end before reading, so a short read after it isn't counted as an underrun
+	bool end = thread_end.load(std::memory_order_acquire);
+
+	size_t read = channel.ring.Read(out, frames * 2) / 2;
+	if (read < frames && !end)
+	{
+		channel.underruns.fetch_add(1, std::memory_order_relaxed);
+		channel.underrun_frames.fetch_add(frames - read, std::memory_order_relaxed);
+	}
+
+	return read;
+}
+
+void XAStream::Seek(size_t index, size_t sector)
+{
+	const XAIndex::Channel *index_channel = channels.at(index)->index_channel;
+	if (index_channel == nullptr || sector >= index_channel->entry_size)
+		throw Types::RuntimeException("XA seek out of range");
+
+	SeekEntry(index, xa_index.Entries(*index_channel)[sector], 0);
+}
+
+void XAStream::SeekFrame(size_t index, uint64_t frame)
+{
+	const XAIndex::Channel *index_channel = channels.at(index)->index_channel;
+	const XAIndex::Entry *entry = index_channel != nullptr ? xa_index.Locate(*index_channel, frame) : nullptr;
+	if (entry == nullptr)
+		throw Types::RuntimeException("XA seek out of range");
+
+	SeekEntry(index, *entry, static_cast<uint32_t>(frame - entry->frame));
+}
+
+void XAStream::SeekEntry(size_t index, const XAIndex::Entry &entry, uint32_t skip_frames)
+{
+	Stop();
+
+	// Drop everything decoded so far and restore each channel's decoder to where it would be at this sector
+	for (auto &channel : channels)
+	{
+		channel->ring.Clear();
+		channel->skip_frames = 0;
+		Restore(*channel, entry.sector);
+	}
+	channels[index]->skip_frames = skip_frames;
+
+	next_sector = entry.sector;
+	file.WillNeed(next_sector * SECTOR_SIZE, READAHEAD_SECTORS * SECTOR_SIZE);
+
+	Start();
+}
+
+void XAStream::Restore(Channel &channel, uint32_t sector)
+{
+	channel.decoder.Reset();
+	if (channel.index_channel == nullptr)
+		return;
+
+	// Find the channel's next sector and the checkpoint before it
+	auto channel_entries = xa_index.Entries(*channel.index_channel);
+
+	size_t target = xa_index.EntryAt(*channel.index_channel, sector);
+	if (target >= channel_entries.Size())
+		return;
+
+	const XAIndex::Checkpoint &checkpoint = xa_index.FindCheckpoint(*channel.index_channel, target);
+	channel.decoder.SetState(checkpoint.state);
+
+	// Decode up to the target sector to get the exact state linear playback would have
+	const char *data = file.GetSpan().Data();
+	for (size_t i = checkpoint.entry; i < target; i++)
+	{
+		if (channel_entries[i].sector >= sectors)
+			break;
+		channel.decoder.DecodeXASector(Types::Span<const char, SECTOR_SIZE>(data + channel_entries[i].sector * SECTOR_SIZE), sector_out);
+	}
+}
+
+size_t XAStream::Sectors(size_t index) const
+{
+	const XAIndex::Channel *index_channel = channels[index]->index_channel;
+	return index_channel != nullptr ? index_channel->entry_size : 0;
+}
+
+uint64_t XAStream::Frames(size_t index) const
+{
+	const XAIndex::Channel *index_channel = channels[index]->index_channel;
+	return index_channel != nullptr ? index_channel->frames : 0;
+}
+
+bool XAStream::End(size_t index) const
+{
+	return thread_end.load(std::memory_order_acquire) && channels[index]->ring.Readable() == 0;
+}
+
+uint32_t XAStream::GetSampleRate(size_t index) const
+{
+	return channels[index]->sample_rate.load(std::memory_order_relaxed);
+}
+
+size_t XAStream::GetBufferedFrames(size_t index) const
+{
+	return channels[index]->ring.Readable() / 2;
+}
+
+uint64_t XAStream::GetUnderruns(size_t index) const
+{
+	return channels[index]->underruns.load(std::memory_order_relaxed);
+}
+
+uint64_t XAStream::GetUnderrunFrames(size_t index) const
+{
+	return channels[index]->underrun_frames.load(std::memory_order_relaxed);
+}
+
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "PS1/ADPCM.h"
+#include "PS1/XAIndex.h"
+
+#include "Types/MmapFile.h"
+#include "Types/RingBuffer.h"
+
+namespace PaperPup::PS1
+{
+
+// Streams a set of interleaved XA channels from disk
+// Every sector is read once on a worker thread and routed to the decoder of the channel it belongs to,
+// the audio thread only copies out decoded frames
+// Seeking goes through an XAIndex of the file, which is cached next to it, and is exact with linear playback
+class XAStream
+{
+public:
+	struct Config
+	{
+		// Number of decoded sectors buffered ahead of playback, per channel
+		size_t prefetch_sectors = 8;
+	};
+
+	struct ChannelID
+	{
+		uint8_t file, channel;
+	};
+
+	static constexpr size_t SECTOR_SIZE = 0x920;
+
+	// Largest number of frames a single sector can decode to
+	static constexpr size_t SECTOR_FRAMES = 28 * 8 * 0x12;
+
+private:
+	// Mapped for sequential reading, sectors are decoded straight from it
+	Types::MmapFile file;
+	size_t sectors;
+	size_t next_sector = 0; // Only touched by the worker, or while it's stopped
+
+	XAIndex xa_index;
+
+	// Demultiplexed channel
+	struct Channel
+	{
+		ChannelID id;
+
+		XADecode decoder;
+
+		// Interleaved stereo samples
+		Types::RingBuffer<int16_t> ring;
+
+		// Index of this channel's sectors, or nullptr if the file doesn't contain it
+		const XAIndex::Channel *index_channel = nullptr;
+
+		// Frames to drop after seeking into the middle of a sector
+		uint32_t skip_frames = 0;
+
+		std::atomic<uint32_t> sample_rate = 0;
+
+		// Statistics
+		std::atomic<uint64_t> underruns = 0;
+		std::atomic<uint64_t> underrun_frames = 0;
+
+		Channel(ChannelID _id, size_t capacity) : id(_id), ring(capacity) {}
+	};
+
+	std::vector<std::unique_ptr<Channel>> channels;
+
+	XADecode::XASectorOut sector_out;
+
+	// Worker thread
+	std::thread thread;
+	std::atomic<bool> thread_quit = false;
+	std::atomic<bool> thread_end = false;
+
+	bool ThreadSleep(int ms);
+	void Thread();
+
+	void Start();
+	void Stop();
+
+	Channel *Route(const SubHeader &subheader) const;
+
+	void SeekEntry(size_t index, const XAIndex::Entry &entry, uint32_t skip_frames);
+	void Restore(Channel &channel, uint32_t sector);
+
+public:
+	XAStream(const std::filesystem::path &path, const std::vector<ChannelID> &ids, const Config &config);
+	XAStream(const std::filesystem::path &path, const std::vector<ChannelID> &ids);
+	~XAStream();
+
+	size_t Channels() const;
+
+	// Called from the audio thread
+	// Copies up to `frames` stereo frames of a channel into `out`, returning how many were copied
+	// The worker only reads ahead while every channel has room, so all channels should be read together
+	size_t Read(size_t index, int16_t *out, size_t frames);
+
+	// Restarts every channel from the given sector or frame of one channel
+	// Must not be called while the audio thread may be reading
+	void Seek(size_t index, size_t sector);
+	void SeekFrame(size_t index, uint64_t frame);
+
+	// Number of sectors and frames belonging to a channel
+	size_t Sectors(size_t index) const;
+	uint64_t Frames(size_t index) const;
+
+	// Whether the end of the file was reached and everything decoded for a channel was read
+	bool End(size_t index) const;
+
+	uint32_t GetSampleRate(size_t index) const;
+
+	size_t GetBufferedFrames(size_t index) const;
+
+	// Number of reads that came up short before the end of the stream, and the total frames missing
+	uint64_t GetUnderruns(size_t index) const;
+	uint64_t GetUnderrunFrames(size_t index) const;
+};
+
+}
@@ -0,0 +1,215 @@
+#include "PS1/TMD.h"
+#include "PS1/TMDMesh.h"
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Conformance test for BuildMesh's primitive decoding
+// Every mode and flags combination gets a synthetic object, checked against what the TMD format says it should decode to
+namespace PaperPup::Tests
+{
+
+using TMD::PrimitiveHeader;
+
+// What one primitive should build into, or `in_words` of 0 if it's not a primitive BuildMesh supports
+struct Expected
+{
+	size_t in_words = 0;
+	size_t vertices = 0;
+	size_t indices = 0;
+	TMD::MeshData::Primitive primitive = TMD::MeshData::Primitive_Triangles;
+	bool textured = false;
+	bool gouraud = false; // Colours vary between vertices
+};
+
+// Words of data after the header, from the TMD format's primitive tables
+// Indexed by [quad][textured][gouraud][gradation]
+static constexpr size_t POLY_LIT_WORDS[2][2][2][2] = {
+	{ { { 3, 5 }, { 4, 6 } }, { { 5, 5 }, { 6, 6 } } },
+	{ { { 4, 7 }, { 5, 8 } }, { { 7, 7 }, { 8, 8 } } },
+};
+static constexpr size_t POLY_UNLIT_WORDS[2][2][2][2] = {
+	{ { { 3, 5 }, { 5, 5 } }, { { 6, 6 }, { 8, 8 } } },
+	{ { { 3, 6 }, { 6, 6 } }, { { 7, 7 }, { 10, 10 } } },
+};
+
+static Expected Expect(uint8_t mode, uint8_t flags)
+{
+	Expected expected;
+	switch (mode & PrimitiveHeader::Mode_Kind_Mask)
+	{
+		case PrimitiveHeader::Mode_Kind_Poly:
+		{
+			bool lit = (flags & PrimitiveHeader::Flag_NoLight) == 0;
+			bool quad = (mode & PrimitiveHeader::Mode_Quad) != 0;
+			bool textured = (mode & PrimitiveHeader::Mode_Textured) != 0;
+			bool gouraud = (mode & PrimitiveHeader::Mode_Gouraud) != 0;
+			bool gradation = (flags & PrimitiveHeader::Flag_Gouraud) != 0;
+			bool double_sided = (flags & PrimitiveHeader::Flag_DoubleSided) != 0;
+
+			expected.in_words = (lit ? POLY_LIT_WORDS : POLY_UNLIT_WORDS)[quad][textured][gouraud][gradation];
+			expected.vertices = quad ? 4 : 3;
+			expected.indices = 3 * (quad ? 2 : 1) * (double_sided ? 2 : 1);
+			expected.textured = textured;
+
+			// Lit primitives only have per-vertex colours with gradation, and textured ones never do
+			if (textured)
+				expected.gouraud = !lit && gouraud;
+			else
+				expected.gouraud = gradation || (!lit && gouraud);
+			break;
+		}
+		case PrimitiveHeader::Mode_Kind_Line:
+		{
+			bool gradation = (mode & PrimitiveHeader::Mode_Gouraud) != 0;
+
+			expected.in_words = gradation ? 3 : 2;
+			expected.vertices = 2;
+			expected.indices = 2;
+			expected.primitive = TMD::MeshData::Primitive_Lines;
+			expected.gouraud = gradation;
+			break;
+		}
+		case PrimitiveHeader::Mode_Kind_Sprite:
+		{
+			// Double sided quads
+			expected.in_words = (mode & PrimitiveHeader::Mode_Size_Mask) == PrimitiveHeader::Mode_Size_Any ? 3 : 2;
+			expected.vertices = 4;
+			expected.indices = 12;
+			expected.textured = true;
+			break;
+		}
+		default:
+			break;
+	}
+	return expected;
+}
+
+// Every halfword of a primitive is different, so every vertex index picks a different vertex,
+// and every colour word is a different colour
+static uint32_t Word(size_t i)
+{
+	return static_cast<uint32_t>(((2 * i + 2) << 16) | (2 * i + 1));
+}
+
+static void Append(std::vector<uint32_t> &words, uint8_t mode, uint8_t flags, size_t in_words)
+{
+	words.push_back((static_cast<uint32_t>(mode) << 24) | (static_cast<uint32_t>(flags) << 16) | (static_cast<uint32_t>(in_words) << 8));
+	for (size_t i = 0; i < in_words; i++)
+		words.push_back(Word(i));
+}
+
+class Test
+{
+private:
+	// Any halfword is a valid vertex index, and every vertex is at a different position
+	std::vector<TMD::Vector> vertices;
+
+	size_t checks = 0;
+	size_t failures = 0;
+
+public:
+	Test() : vertices(0x10000)
+	{
+		for (size_t i = 0; i < vertices.size(); i++)
+			vertices[i] = { static_cast<int16_t>(i), static_cast<int16_t>(~i), static_cast<int16_t>(i ^ 0x5555), 0 };
+	}
+
+	TMD::MeshData Build(std::vector<uint32_t> &words, uint32_t primitives)
+	{
+		TMD::Data::Object object = {};
+		object.vertex_p = vertices.data();
+		object.primitive_p = words.data();
+		object.vertex_size = static_cast<uint32_t>(vertices.size());
+		object.primitive_size = primitives;
+		object.primitive_words = static_cast<uint32_t>(words.size());
+		return TMD::BuildMesh(object, false);
+	}
+
+	void Check(bool condition, uint8_t mode, uint8_t flags, const char *what)
+	{
+		checks++;
+		if (condition)
+			return;
+
+		failures++;
+		std::cerr << "Mode 0x" << std::hex << static_cast<unsigned>(mode) << " flags 0x" << static_cast<unsigned>(flags) << std::dec << ": " << what << std::endl;
+	}
+
+	void Run(uint8_t mode, uint8_t flags)
+	{
+		const Expected expected = Expect(mode, flags);
+
+		if (expected.in_words != 0)
+		{
+			// The primitive decodes as the format says
+			std::vector<uint32_t> words;
+			Append(words, mode, flags, expected.in_words);
+			TMD::MeshData mesh = Build(words, 1);
+
+			Check(mesh.vertices.size() == expected.vertices, mode, flags, "wrong vertex count");
+			Check(mesh.indices.size() == expected.indices, mode, flags, "wrong index count");
+			Check(mesh.draws.size() == 1 && mesh.draws[0].primitive == expected.primitive && mesh.draws[0].count == expected.indices, mode, flags, "wrong draw");
+			Check(mesh.unsupported == 0, mode, flags, "counted as unsupported");
+
+			bool textured = !mesh.vertices.empty();
+			bool gouraud = false;
+			for (auto &vertex : mesh.vertices)
+			{
+				textured &= (vertex.attribute.flags & TMD::MeshVertex::Flag_Textured) != 0;
+
+				const auto &first = mesh.vertices.front().attribute;
+				gouraud |= vertex.attribute.r != first.r || vertex.attribute.g != first.g || vertex.attribute.b != first.b;
+			}
+			Check(textured == expected.textured, mode, flags, expected.textured ? "should be textured" : "shouldn't be textured");
+			Check(gouraud == expected.gouraud, mode, flags, expected.gouraud ? "should be gouraud" : "shouldn't be gouraud");
+
+			// A primitive with the wrong size is skipped, and the one after it still decodes
+			for (size_t in_words : { expected.in_words - 1, expected.in_words + 1 })
+			{
+				std::vector<uint32_t> mismatched;
+				Append(mismatched, mode, flags, in_words);
+				Append(mismatched, mode, flags, expected.in_words);
+				TMD::MeshData skipped = Build(mismatched, 2);
+
+				Check(skipped.vertices == mesh.vertices && skipped.indices == mesh.indices, mode, flags, "mismatched size wasn't skipped");
+				Check(skipped.unsupported == 1, mode, flags, "mismatched size wasn't counted");
+			}
+		}
+		else
+		{
+			// Nothing decodes, whatever the size
+			for (size_t in_words : { 0, 2, 3, 6 })
+			{
+				std::vector<uint32_t> words;
+				Append(words, mode, flags, in_words);
+				TMD::MeshData mesh = Build(words, 1);
+
+				Check(mesh.vertices.empty() && mesh.indices.empty() && mesh.draws.empty(), mode, flags, "unsupported kind decoded");
+				Check(mesh.unsupported == 1, mode, flags, "unsupported kind wasn't counted");
+			}
+		}
+	}
+
+	int Finish() const
+	{
+		std::cout << checks - failures << "/" << checks << " checks passed" << std::endl;
+		return failures != 0;
+	}
+};
+
+}
+
+int main()
+{
+	PaperPup::Tests::Test test;
+
+	for (unsigned mode = 0; mode < 0x100; mode++)
+	{
+		for (unsigned flags = 0; flags < 8; flags++)
+			test.Run(static_cast<uint8_t>(mode), static_cast<uint8_t>(flags));
+	}
+	return test.Finish();
+}
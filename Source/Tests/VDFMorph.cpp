@@ -0,0 +1,82 @@
+#include "PS1/VDFMorph.h"
+
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// Checks that Accumulate matches AccumulateReference exactly
+// Where Accumulate is the SIMD kernel, this is the only thing comparing the two
+namespace PaperPup::Tests
+{
+
+// Lanes of deltas per weight, random ones followed by the extremes
+static constexpr size_t COUNT = 1024;
+static constexpr int16_t EXTREMES[] = { -0x8000, -0x7FFF, -0x1000, -1, 0, 1, 0x1000, 0x7FFE, 0x7FFF };
+
+static_assert(COUNT % VDF::Morph::LANES == 0);
+
+}
+
+int main()
+{
+	using namespace PaperPup;
+
+	std::mt19937 random(0x50504D52);
+	std::uniform_int_distribution<int32_t> halfword(-0x8000, 0x7FFF);
+
+	std::vector<int16_t> delta(Tests::COUNT + std::size(Tests::EXTREMES) * std::size(Tests::EXTREMES));
+	std::vector<int16_t> base(delta.size());
+	for (size_t i = 0; i < Tests::COUNT; i++)
+	{
+		delta[i] = static_cast<int16_t>(halfword(random));
+		base[i] = static_cast<int16_t>(halfword(random));
+	}
+
+	// Every extreme delta added to every extreme position, so saturation and wrapping are both hit
+	size_t extreme = Tests::COUNT;
+	for (int16_t d : Tests::EXTREMES)
+	{
+		for (int16_t b : Tests::EXTREMES)
+		{
+			delta[extreme] = d;
+			base[extreme] = b;
+			extreme++;
+		}
+	}
+
+	// Rounded up to whole lanes
+	while (delta.size() % VDF::Morph::LANES != 0)
+	{
+		delta.push_back(0);
+		base.push_back(0);
+	}
+
+	// Every 7th weight, and every extreme one
+	std::vector<int16_t> weights;
+	for (int32_t weight = -0x8000; weight <= 0x7FFF; weight += 7)
+		weights.push_back(static_cast<int16_t>(weight));
+	weights.insert(weights.end(), std::begin(Tests::EXTREMES), std::end(Tests::EXTREMES));
+
+	size_t mismatches = 0;
+	std::vector<int16_t> out(delta.size()), reference(delta.size());
+	for (int16_t weight : weights)
+	{
+		out = base;
+		reference = base;
+		VDF::Accumulate(out.data(), delta.data(), weight, out.size());
+		VDF::AccumulateReference(reference.data(), delta.data(), weight, reference.size());
+
+		for (size_t i = 0; i < out.size(); i++)
+		{
+			if (out[i] == reference[i])
+				continue;
+
+			if (mismatches++ < 16)
+				std::cout << "weight " << weight << ", delta " << delta[i] << ", base " << base[i] << ": " << out[i] << " instead of " << reference[i] << std::endl;
+		}
+	}
+
+	std::cout << weights.size() << " weights, " << mismatches << " mismatches" << std::endl;
+	return mismatches != 0;
+}
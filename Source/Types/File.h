@@ -2,6 +2,7 @@
 
 #include <filesystem>
 #include <fstream>
+#include <memory>
 
 #include "Types/Span.h"
 
@@ -98,4 +99,14 @@ public:
 	}
 };
 
+// File over a buffer it owns
+class MemoryFile : public File
+{
+private:
+	std::unique_ptr<char[]> data;
+
+public:
+	MemoryFile(std::unique_ptr<char[]> _data, size_t size) : File(Span<char>(_data.get(), size)), data(std::move(_data)) {}
+};
+
 }
@@ -0,0 +1,139 @@
+#include "Types/MmapFile.h"
+
+#include <algorithm>
+
+#if defined(WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace PaperPup::Types
+{
+
+#if defined(WIN32)
+Span<char> MmapFile::GetSpan(const std::filesystem::path &path, Access access)
+{
+	mapping = nullptr;
+	mapping_size = 0;
+
+	DWORD flags = FILE_ATTRIBUTE_NORMAL;
+	if (access == Access_Sequential)
+		flags |= FILE_FLAG_SEQUENTIAL_SCAN;
+	else if (access == Access_Random)
+		flags |= FILE_FLAG_RANDOM_ACCESS;
+
+	HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, flags, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		throw Win32Exception();
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size))
+	{
+		CloseHandle(file);
+		throw Win32Exception();
+	}
+
+	// Empty files can't be mapped
+	if (size.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return Span<char>(nullptr, 0);
+	}
+
+	// The view keeps the mapping and file referenced, so neither handle is needed after this
+	HANDLE file_mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(file);
+	if (file_mapping == nullptr)
+		throw Win32Exception();
+
+	void *data = MapViewOfFile(file_mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(file_mapping);
+	if (data == nullptr)
+		throw Win32Exception();
+
+	mapping = data;
+	mapping_size = static_cast<size_t>(size.QuadPart);
+	return Span<char>(static_cast<char*>(data), mapping_size);
+}
+
+MmapFile::~MmapFile()
+{
+	if (mapping != nullptr)
+		UnmapViewOfFile(mapping);
+}
+
+void MmapFile::WillNeed(size_t offset, size_t size) const
+{
+	if (offset >= mapping_size)
+		return;
+
+	WIN32_MEMORY_RANGE_ENTRY range;
+	range.VirtualAddress = static_cast<char*>(mapping) + offset;
+	range.NumberOfBytes = std::min(size, mapping_size - offset);
+	PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+}
+#else
+Span<char> MmapFile::GetSpan(const std::filesystem::path &path, Access access)
+{
+	mapping = nullptr;
+	mapping_size = 0;
+
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		throw RuntimeException("Failed to open file");
+
+	struct stat st;
+	if (fstat(fd, &st) != 0)
+	{
+		close(fd);
+		throw RuntimeException("Failed to stat file");
+	}
+
+	// Empty files can't be mapped
+	size_t size = static_cast<size_t>(st.st_size);
+	if (size == 0)
+	{
+		close(fd);
+		return Span<char>(nullptr, 0);
+	}
+
+	// The mapping keeps the file referenced, so the descriptor isn't needed after this
+	void *data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+		throw RuntimeException("Failed to map file");
+
+	if (access == Access_Sequential)
+		madvise(data, size, MADV_SEQUENTIAL);
+	else if (access == Access_Random)
+		madvise(data, size, MADV_RANDOM);
+
+	mapping = data;
+	mapping_size = size;
+	return Span<char>(static_cast<char*>(data), size);
+}
+
+MmapFile::~MmapFile()
+{
+	if (mapping != nullptr)
+		munmap(mapping, mapping_size);
+}
+
+void MmapFile::WillNeed(size_t offset, size_t size) const
+{
+	if (offset >= mapping_size)
+		return;
+
+	// madvise wants a page aligned start
+	size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	size_t start = offset - offset % page;
+	madvise(static_cast<char*>(mapping) + start, std::min(size, mapping_size - offset) + (offset - start), MADV_WILLNEED);
+}
+#endif
+
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <filesystem>
+
+#include "Types/File.h"
+
+namespace PaperPup::Types
+{
+
+// File mapped read-only into memory instead of read, so only the pages that get touched are loaded,
+// and they're shared with the page cache rather than copied
+// Nothing may be written through the span
+class MmapFile : public File
+{
+public:
+	// How the file is expected to be read, so the OS can read ahead or not
+	enum Access
+	{
+		Access_Normal,
+		Access_Sequential, // Read once front to back, like streamed audio
+		Access_Random, // Read in scattered pieces, like archive members
+	};
+
+private:
+	// Same as StlFile, these are set up by GetSpan before File is initialized
+	void *mapping;
+	size_t mapping_size;
+
+	Span<char> GetSpan(const std::filesystem::path &path, Access access);
+
+public:
+	MmapFile(const std::filesystem::path &path, Access access = Access_Normal) : File(GetSpan(path, access)) {}
+	~MmapFile() override;
+
+	using File::GetSpan;
+
+	// Hints that a range is about to be read, so it can be paged in ahead of time
+	void WillNeed(size_t offset, size_t size) const;
+};
+
+}
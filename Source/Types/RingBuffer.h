@@ -0,0 +1,99 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+namespace PaperPup::Types
+{
+
+// Lock-free single-producer single-consumer ring buffer
+// One thread may only write, and one other thread may only read
+template <typename T>
+class RingBuffer
+{
+	static_assert(std::is_trivially_copyable_v<T>, "T must be trivially copyable");
+
+private:
+	std::unique_ptr<T[]> data;
+	size_t capacity = 0;
+
+	// Positions only ever increase, and are wrapped by the capacity when accessing data
+	alignas(64) std::atomic<size_t> write_p = 0;
+	alignas(64) std::atomic<size_t> read_p = 0;
+
+public:
+	// Capacity is rounded up to a power of 2
+	RingBuffer(size_t min_capacity) : capacity(std::bit_ceil(min_capacity))
+	{
+		data = std::make_unique<T[]>(capacity);
+	}
+
+	RingBuffer(const RingBuffer &) = delete;
+	RingBuffer &operator=(const RingBuffer &) = delete;
+
+	size_t Capacity() const
+	{
+		return capacity;
+	}
+
+	// Producer
+	size_t Writable() const
+	{
+		return capacity - (write_p.load(std::memory_order_relaxed) - read_p.load(std::memory_order_acquire));
+	}
+
+	size_t Write(const T *src, size_t count)
+	{
+		size_t write = write_p.load(std::memory_order_relaxed);
+		size_t read = read_p.load(std::memory_order_acquire);
+
+		if (count > capacity - (write - read))
+			count = capacity - (write - read);
+
+		// Copy in up to two parts, split at the end of the buffer
+		size_t offset = write & (capacity - 1);
+		size_t first = std::min(count, capacity - offset);
+		std::memcpy(data.get() + offset, src, first * sizeof(T));
+		std::memcpy(data.get(), src + first, (count - first) * sizeof(T));
+
+		write_p.store(write + count, std::memory_order_release);
+		return count;
+	}
+
+	// Consumer
+	size_t Readable() const
+	{
+		return write_p.load(std::memory_order_acquire) - read_p.load(std::memory_order_relaxed);
+	}
+
+	size_t Read(T *dst, size_t count)
+	{
+		size_t read = read_p.load(std::memory_order_relaxed);
+		size_t write = write_p.load(std::memory_order_acquire);
+
+		if (count > write - read)
+			count = write - read;
+
+		// Copy out in up to two parts, split at the end of the buffer
+		size_t offset = read & (capacity - 1);
+		size_t first = std::min(count, capacity - offset);
+		std::memcpy(dst, data.get() + offset, first * sizeof(T));
+		std::memcpy(dst + first, data.get(), (count - first) * sizeof(T));
+
+		read_p.store(read + count, std::memory_order_release);
+		return count;
+	}
+
+	// Drops everything buffered
+	// Only valid while the producer is stopped
+	void Clear()
+	{
+		read_p.store(write_p.load(std::memory_order_acquire), std::memory_order_release);
+	}
+};
+
+}